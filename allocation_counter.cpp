@@ -0,0 +1,34 @@
+#include <cstdlib>
+#include <new>
+
+#include "compiler_statistics.h"
+
+// Replaces the global operator new of the executable for the allocation counts of
+// --stats. It is linked into the executable, not into comcalc_lib, so the replacement
+// doesn't depend on which objects of the library the linker happens to pull in.
+void* operator new(std::size_t size) {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+	if (size == 0)
+		size = 1;
+
+	while (true) {
+		void* memory = std::malloc(size);
+		if (memory != nullptr)
+			return memory;
+
+		auto handler = std::get_new_handler();
+		if (handler == nullptr)
+			throw std::bad_alloc();
+
+		handler();
+	}
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
@@ -0,0 +1,25 @@
+#include "arena.h"
+
+arena::~arena() {
+	for (auto i = _destructors.crbegin(); i != _destructors.crend(); i++)
+		i->destroy(i->object);
+}
+
+void* arena::allocate(size_t size, size_t alignment) {
+	size_t padding = (alignment - (size_t)_position % alignment) % alignment;
+
+	if (_position == nullptr || padding + size > (size_t)(_end - _position)) {
+		// Blocks are allocated by `new char[]`, so they are aligned for any node.
+		size_t length = size > block_size ? size : block_size;
+		_blocks.push_back(std::unique_ptr<char[]>(new char[length]));
+		_position = _blocks.back().get();
+		_end = _position + length;
+		padding = 0;
+	}
+
+	void* result = _position + padding;
+	_position += padding + size;
+	_allocated_bytes += size;
+
+	return result;
+}
@@ -0,0 +1,56 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump-pointer allocator. Objects are placed one after another into large blocks
+// and are released together with the arena, so there is no `delete` per object.
+// Destructors are called only for objects which are not trivially destructible.
+class arena
+{
+private:
+	struct destructor
+	{
+		void (*destroy)(void*);
+		void* object;
+	};
+
+	static const size_t block_size = 64 * 1024;
+
+	std::vector<std::unique_ptr<char[]>> _blocks;
+	std::vector<destructor> _destructors;
+	char* _position;
+	char* _end;
+	size_t _allocated_bytes;
+
+	void* allocate(size_t size, size_t alignment);
+
+public:
+	arena() : _position(nullptr), _end(nullptr), _allocated_bytes(0) { }
+
+	arena(const arena&) = delete;
+
+	arena& operator=(const arena&) = delete;
+
+	~arena();
+
+	template<typename T, typename... Args>
+	T* create(Args&&... args) {
+		void* memory = allocate(sizeof(T), alignof(T));
+		T* result = new (memory) T(std::forward<Args>(args)...);
+
+		if (!std::is_trivially_destructible<T>::value)
+			_destructors.push_back(destructor{ [](void* object) { static_cast<T*>(object)->~T(); }, result });
+
+		return result;
+	}
+
+	size_t allocated_bytes() const { return _allocated_bytes; }
+};
+
+#endif
@@ -2,17 +2,25 @@
 #define __AST_H__
 
 #include <map>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include "arena.h"
 #include "expression.h"
+#include "symbol_table.h"
 #include "visitor.h"
 
+// Nodes are placed into the arena owned by ast_program and are never deleted one by one.
+// Children are not deleted by their parents, so most of the nodes are trivially destructible
+// and the whole tree is released at once together with the arena.
 class ast_node
 {
-public:
-    virtual ~ast_node() { }
+protected:
+    ~ast_node() = default;
 
+public:
     virtual void accept(visitor&) const = 0;
 };
 
@@ -41,11 +49,6 @@ public:
 		_right = right;
 	}
 
-	virtual ~ast_logical_binary_operator() {
-		delete _left;
-		delete _right;
-	}
-
 	virtual void accept(visitor& visitor) const {
 		visitor.visit_logical_binary_operator(this);
 	}
@@ -73,10 +76,6 @@ public:
 		_operand = operand;
 	}
 
-	virtual ~ast_logical_not_operator() {
-		delete _operand;
-	}
-
 	virtual void accept(visitor& visitor) const {
 		visitor.visit_logical_not_operator(this);
 	}
@@ -100,11 +99,6 @@ public:
 		_right = right;
 	}
 
-	virtual ~ast_condition() {
-		delete _left;
-		delete _right;
-	}
-
 	virtual void accept(visitor& visitor) const {
 		visitor.visit_condition(this);
 	}
@@ -132,7 +126,7 @@ enum class binary_operation
     Pow,
 };
 
-std::string to_string(binary_operation operation) {
+inline std::string to_string(binary_operation operation) {
     if (operation == binary_operation::Add)
         return "+";
 
@@ -160,17 +154,14 @@ private:
     binary_operation _operation;
     const ast_expression* _left;
     const ast_expression* _right;
+    mutable expression_type _type;
 
 public:
     ast_binary_operator(binary_operation operation, const ast_expression* left, const ast_expression* right) {
         _operation = operation;
         _left = left;
         _right = right;
-    }
-
-    virtual ~ast_binary_operator() {
-        delete _left;
-        delete _right;
+        update_type();
     }
 
     virtual void accept(visitor& visitor) const {
@@ -178,13 +169,17 @@ public:
     }
 
     virtual expression_type type() const {
-        if (operation() == binary_operation::Pow)
-            return expression_type::Double;
-
-        if (left()->type() == expression_type::Double || right()->type() == expression_type::Double)
-            return expression_type::Double;
+        return _type;
+    }
 
-        return expression_type::Long;
+    // Types of operators are computed from the types of their operands once. Calls among
+    // the operands are typed later, so step1_tables_builder updates the types after them.
+    void update_type() const {
+        if (operation() == binary_operation::Pow || left()->type() == expression_type::Double
+            || right()->type() == expression_type::Double)
+            _type = expression_type::Double;
+        else
+            _type = expression_type::Long;
     }
 
     const binary_operation operation() const {
@@ -206,7 +201,7 @@ enum class unary_operation
     Positive,
 };
 
-std::string to_string(unary_operation operation) {
+inline std::string to_string(unary_operation operation) {
     if (operation == unary_operation::Negative)
         return "-";
 
@@ -221,15 +216,13 @@ class ast_unary_operator : public ast_expression
 private:
     unary_operation _operation;
     const ast_expression* _operand;
+    mutable expression_type _type;
 
 public:
     ast_unary_operator(unary_operation operation, const ast_expression* operand) {
         _operation = operation;
         _operand = operand;
-    }
-
-    virtual ~ast_unary_operator() {
-        delete _operand;
+        update_type();
     }
 
     virtual void accept(visitor& visitor) const {
@@ -237,7 +230,11 @@ public:
     }
 
     virtual expression_type type() const {
-        return operand()->type();
+        return _type;
+    }
+
+    void update_type() const {
+        _type = operand()->type();
     }
 
     const unary_operation operation() const {
@@ -295,22 +292,27 @@ public:
     }
 };
 
+// Named nodes keep the id of the interned name and a reference to the name itself,
+// which lives in the symbol table of the program.
 class ast_variable : public ast_expression
 {
 private:
-    std::string _name;
+    symbol_id _symbol;
+    const std::string* _name;
     bool _hasType;
     expression_type _type;
 
 public:
-    ast_variable(std::string name) {
-        _name = name;
+    ast_variable(symbol_id symbol, const std::string& name) {
+        _symbol = symbol;
+        _name = &name;
         _hasType = false;
         _type = (expression_type)0;
     }
 
-    ast_variable(std::string name, expression_type type) {
-        _name = name;
+    ast_variable(symbol_id symbol, const std::string& name, expression_type type) {
+        _symbol = symbol;
+        _name = &name;
         _hasType = true;
         _type = type;
     }
@@ -323,8 +325,12 @@ public:
         return _type;
     }
 
+    symbol_id symbol() const {
+        return _symbol;
+    }
+
     const std::string &name() const {
-        return _name;
+        return *_name;
     }
 };
 
@@ -332,21 +338,28 @@ class ast_call : public ast_variable
 {
 private:
     std::vector<const ast_expression*> _parameters;
+    mutable expression_type _type;
 
 public:
-    ast_call(std::string name, std::vector<const ast_expression*> parameters) : ast_variable(name) {
+    ast_call(symbol_id symbol, const std::string& name, const std::vector<const ast_expression*>& parameters) : ast_variable(symbol, name) {
         _parameters = parameters;
-    }
-
-    ~ast_call() {
-        for (std::vector<const ast_expression*>::iterator i = _parameters.begin(); i != _parameters.end(); i++)
-            delete *i;
+        _type = expression_type::Double;
     }
 
     virtual void accept(visitor& visitor) const {
         visitor.visit_call(this);
     }
 
+    virtual expression_type type() const {
+        return _type;
+    }
+
+    // The result type of a user function is known only when the function is declared,
+    // so it is resolved by step1_tables_builder.
+    void set_type(expression_type type) const {
+        _type = type;
+    }
+
     const std::vector<const ast_expression*> &parameters() const {
         return _parameters;
     }
@@ -358,18 +371,14 @@ private:
 	const ast_logical_expression* _logical_expression;
 	const ast_expression* _then_expression;
 	const ast_expression* _else_expression;
+	mutable expression_type _type;
 
 public:
 	ast_if_then_else(const ast_logical_expression* logical_expression, const ast_expression* then_expression, const ast_expression* else_expression)	{
 		_logical_expression = logical_expression;
 		_then_expression = then_expression;
 		_else_expression = else_expression;
-	}
-
-	~ast_if_then_else() {
-		delete _logical_expression;
-		delete _then_expression;
-		delete _else_expression;
+		update_type();
 	}
 
 	virtual void accept(visitor& visitor) const {
@@ -377,15 +386,16 @@ public:
 	}
 
     virtual expression_type type() const {
-        if (then_expression()->type() == expression_type::Double)
-            return expression_type::Double;
-
-        if (else_expression()->type() == expression_type::Double)
-            return expression_type::Double;
-
-        return expression_type::Long;
+        return _type;
     }
 
+	void update_type() const {
+		if (then_expression()->type() == expression_type::Double || else_expression()->type() == expression_type::Double)
+			_type = expression_type::Double;
+		else
+			_type = expression_type::Long;
+	}
+
 	const ast_logical_expression* logical_expression() const {
 		return _logical_expression;
 	}
@@ -402,33 +412,43 @@ public:
 class ast_function : public ast_node
 {
 private:
-    std::string _name;
-    std::map<std::string, expression_type> _parameters;
+    symbol_id _symbol;
+    const std::string* _name;
+    std::vector<std::pair<std::string, expression_type>> _parameters;
+    std::vector<symbol_id> _parameter_symbols;
     const ast_expression* _expression;
 
 public:
-    ast_function(const std::string& name, const std::map<std::string, expression_type>& parameters, const ast_expression* expression) {
-        _name = name;
+    ast_function(symbol_id symbol, const std::string& name, const std::vector<std::pair<std::string, expression_type>>& parameters,
+        const std::vector<symbol_id>& parameter_symbols, const ast_expression* expression) {
+        _symbol = symbol;
+        _name = &name;
         _parameters = parameters;
+        _parameter_symbols = parameter_symbols;
         _expression = expression;
     }
 
-    virtual ~ast_function() {
-        delete _expression;
-    }
-
     virtual void accept(visitor& visitor) const {
         visitor.visit_function(this);
     }
 
+    symbol_id symbol() const {
+        return _symbol;
+    }
+
     const std::string &name() const {
-        return _name;
+        return *_name;
     }
 
-    const std::map<std::string, expression_type> &parameters() const {
+    const std::vector<std::pair<std::string, expression_type>> &parameters() const {
         return _parameters;
     }
 
+    // Symbols of parameters in the same order as parameters().
+    const std::vector<symbol_id> &parameter_symbols() const {
+        return _parameter_symbols;
+    }
+
     const ast_expression* expression() const {
         return _expression;
     }
@@ -437,25 +457,27 @@ public:
 class ast_assignment : public ast_node
 {
 private:
-    std::string _name;
+    symbol_id _symbol;
+    const std::string* _name;
     const ast_expression* _expression;
 
 public:
-    ast_assignment(const std::string& name, const ast_expression* expression) {
-        _name = name;
+    ast_assignment(symbol_id symbol, const std::string& name, const ast_expression* expression) {
+        _symbol = symbol;
+        _name = &name;
         _expression = expression;
     }
 
-    virtual ~ast_assignment() {
-        delete _expression;
-    }
-
     virtual void accept(visitor& visitor) const {
         visitor.visit_assignment(this);
     }
 
+    symbol_id symbol() const {
+        return _symbol;
+    }
+
     const std::string& name() const {
-        return _name;
+        return *_name;
     }
 
     const ast_expression* expression() const {
@@ -463,26 +485,34 @@ public:
     }
 };
 
-class ast_program : public ast_node
+// The program owns the arena of all its nodes and the table of all its identifiers.
+// It is the only node allocated with `new`.
+class ast_program final : public ast_node
 {
 private:
+    ::arena* _arena;
+    symbol_table* _symbols;
     std::vector<const ast_function*> _functions;
     std::vector<const ast_assignment*> _assignments;
 
 public:
-    ast_program(const std::vector<const ast_function*>& functions, const std::vector<const ast_assignment*>& assignments) {
+    ast_program(::arena* arena, symbol_table* symbols, const std::vector<const ast_function*>& functions,
+        const std::vector<const ast_assignment*>& assignments) {
+        _arena = arena;
+        _symbols = symbols;
         _functions = functions;
         _assignments = assignments;
     }
 
-    virtual ~ast_program() {
-        for (std::vector<const ast_function*>::iterator i = _functions.begin(); i != _functions.end(); i++)
-            delete *i;
-
-        for (std::vector<const ast_assignment*>::iterator i = _assignments.begin(); i != _assignments.end(); i++)
-            delete *i;
+    ~ast_program() {
+        delete _arena;
+        delete _symbols;
     }
 
+    ast_program(const ast_program&) = delete;
+
+    ast_program& operator=(const ast_program&) = delete;
+
     virtual void accept(visitor& visitor) const {
         visitor.visit_program(this);
     }
@@ -494,6 +524,22 @@ public:
     const std::vector<const ast_assignment*>& assignments() const {
         return _assignments;
     }
+
+    ::arena& arena() const {
+        return *_arena;
+    }
+
+    const symbol_table& symbols() const {
+        return *_symbols;
+    }
 };
 
+// Operators and constants make up most of the tree. They own nothing, so the arena
+// doesn't even have to call their destructors.
+static_assert(std::is_trivially_destructible<ast_binary_operator>::value, "ast_binary_operator must be trivially destructible.");
+static_assert(std::is_trivially_destructible<ast_unary_operator>::value, "ast_unary_operator must be trivially destructible.");
+static_assert(std::is_trivially_destructible<ast_long>::value, "ast_long must be trivially destructible.");
+static_assert(std::is_trivially_destructible<ast_double>::value, "ast_double must be trivially destructible.");
+static_assert(std::is_trivially_destructible<ast_variable>::value, "ast_variable must be trivially destructible.");
+
 #endif
\ No newline at end of file
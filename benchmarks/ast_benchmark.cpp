@@ -0,0 +1,98 @@
+// Scans and parses a large machine-generated program and measures scanning, parsing
+// and teardown of its AST.
+//
+//   ast_benchmark [assignments] [terms]
+//
+// Every assignment is a sum of `terms` products, calls and conditional expressions,
+// so the tree has about 10 * assignments * terms nodes.
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../parser.h"
+
+static std::string generate_program(int assignments, int terms) {
+	std::ostringstream out;
+	out << "f(x) = if x > 0 then x * 2.5 else -x" << std::endl;
+
+	for (int i = 0; i < assignments; i++) {
+		out << "y" << i << " = ";
+		for (int j = 0; j < terms; j++) {
+			if (j > 0)
+				out << (j % 2 == 0 ? " + " : " - ");
+
+			switch (j % 3) {
+			case 0:
+				out << "a" << j % 7 << " * " << j << " / (b + 1.5)";
+				break;
+			case 1:
+				out << "sqrt(c" << j % 5 << " ^ 2) % 3";
+				break;
+			default:
+				out << "f(a" << j % 7 << " - " << j << ")";
+				break;
+			}
+		}
+		out << std::endl;
+	}
+
+	return out.str();
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, const char* const* argv) {
+	int assignments = argc > 1 ? std::stoi(argv[1]) : 2000;
+	int terms = argc > 2 ? std::stoi(argv[2]) : 100;
+	int repetitions = 5;
+
+	std::string text = generate_program(assignments, terms);
+	double scan_time = 0.0;
+	size_t lexeme_count = 0;
+	double parse_time = 0.0;
+	double teardown_time = 0.0;
+
+	try {
+		for (int i = 0; i < repetitions; i++) {
+			auto start = std::chrono::steady_clock::now();
+
+			for (scanner scanner(text); scanner.lexeme() != lexeme::Eof; scanner.next())
+				lexeme_count++;
+
+			scan_time += seconds_since(start);
+		}
+
+		for (int i = 0; i < repetitions; i++) {
+			std::istringstream in(text);
+			auto start = std::chrono::steady_clock::now();
+
+			parser parser(in);
+			const ast_program* program = parser.parse_program();
+			parse_time += seconds_since(start);
+
+			start = std::chrono::steady_clock::now();
+			delete program;
+			teardown_time += seconds_since(start);
+		}
+	}
+	catch (std::exception* exception) {
+		std::cerr << exception->what() << std::endl;
+		delete exception;
+
+		return 1;
+	}
+
+	double megabytes = text.size() / (1024.0 * 1024.0);
+	std::cout << "source:   " << megabytes << " MB, " << assignments << " assignments of " << terms << " terms" << std::endl;
+	std::cout << "scan:     " << 1000.0 * scan_time / repetitions << " ms ("
+		<< megabytes * repetitions / scan_time << " MB/s, " << lexeme_count / repetitions << " lexemes)" << std::endl;
+	std::cout << "parse:    " << 1000.0 * parse_time / repetitions << " ms ("
+		<< megabytes * repetitions / parse_time << " MB/s)" << std::endl;
+	std::cout << "teardown: " << 1000.0 * teardown_time / repetitions << " ms" << std::endl;
+
+	return 0;
+}
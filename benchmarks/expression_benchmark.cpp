@@ -0,0 +1,171 @@
+// Parses single expressions of a million terms of several shapes, reports the time per
+// term and checks that every tree has the shape the grammar gives it.
+//
+//   expression_benchmark [terms]
+//
+// `terms` is the number of terms of every expression, 1000000 by default. The trees are
+// as deep as the expressions are long, so they are walked with loops, not visitors.
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../parser.h"
+
+struct shape
+{
+	const char* name;
+	std::function<std::string(int)> generate;
+	// Returns the number of terms found in the tree of the assignment.
+	std::function<int(const ast_expression*)> count_terms;
+};
+
+// `a + 2 - a + 2 ...`, a tree leaning to the left.
+static std::string generate_sum(int terms) {
+	std::string text = "y = a";
+	for (int i = 1; i < terms; i++)
+		text += i % 2 == 0 ? " - a" : " + 2";
+
+	return text + "\n";
+}
+
+static int count_left_terms(const ast_expression* expression) {
+	int terms = 1;
+	for (auto binary = dynamic_cast<const ast_binary_operator*>(expression); binary != nullptr;
+		binary = dynamic_cast<const ast_binary_operator*>(binary->left()))
+		terms++;
+
+	return terms;
+}
+
+// `a * 2 + a * 2 ...`, products under a sum.
+static std::string generate_sum_of_products(int terms) {
+	std::string text = "y = a";
+	for (int i = 1; i < terms; i++)
+		text += i % 2 == 0 ? " + a" : " * 2";
+
+	return text + "\n";
+}
+
+static int count_product_terms(const ast_expression* expression) {
+	int terms = 0;
+
+	for (auto sum = dynamic_cast<const ast_binary_operator*>(expression); sum != nullptr
+		&& sum->operation() == binary_operation::Add; sum = dynamic_cast<const ast_binary_operator*>(sum->left())) {
+		terms += count_left_terms(sum->right());
+		expression = sum->left();
+	}
+
+	return terms + count_left_terms(expression);
+}
+
+// `a ^ a ^ a ...`, a tree leaning to the right.
+static std::string generate_power_chain(int terms) {
+	std::string text = "y = a";
+	for (int i = 1; i < terms; i++)
+		text += " ^ a";
+
+	return text + "\n";
+}
+
+static int count_right_terms(const ast_expression* expression) {
+	int terms = 1;
+	for (auto binary = dynamic_cast<const ast_binary_operator*>(expression); binary != nullptr;
+		binary = dynamic_cast<const ast_binary_operator*>(binary->right()))
+		terms++;
+
+	return terms;
+}
+
+// `-(a + -(a + ... ))`, parentheses nested as deep as the expression is long.
+static std::string generate_nested_parentheses(int terms) {
+	std::string text = "y = ";
+	for (int i = 1; i < terms; i++)
+		text += "-(a + ";
+
+	text += "a";
+	text.append(terms - 1, ')');
+
+	return text + "\n";
+}
+
+static int count_nested_terms(const ast_expression* expression) {
+	int terms = 1;
+	for (auto negative = dynamic_cast<const ast_unary_operator*>(expression); negative != nullptr;
+		negative = dynamic_cast<const ast_unary_operator*>(static_cast<const ast_binary_operator*>(negative->operand())->right()))
+		terms++;
+
+	return terms;
+}
+
+// `if a > 1 or a > 1 ... then 1 else 2`, a long condition.
+static std::string generate_condition(int terms) {
+	std::string text = "y = if a > 1";
+	for (int i = 1; i < terms; i++)
+		text += " or a > 1";
+
+	return text + " then 1 else 2\n";
+}
+
+static int count_condition_terms(const ast_expression* expression) {
+	auto if_then_else = static_cast<const ast_if_then_else*>(expression);
+	int terms = 1;
+
+	for (auto binary = dynamic_cast<const ast_logical_binary_operator*>(if_then_else->logical_expression());
+		binary != nullptr; binary = dynamic_cast<const ast_logical_binary_operator*>(binary->left()))
+		terms++;
+
+	return terms;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void measure(const shape& shape, int terms) {
+	std::string text = shape.generate(terms);
+
+	auto start = std::chrono::steady_clock::now();
+	parser parser(text);
+	const ast_program* program = parser.parse_program();
+	double parse_time = seconds_since(start);
+
+	int found_terms = shape.count_terms(program->assignments()[0]->expression());
+	delete program;
+
+	if (found_terms != terms)
+		throw new std::runtime_error(std::string(shape.name) + ": " + std::to_string(found_terms)
+			+ " terms parsed instead of " + std::to_string(terms) + ".");
+
+	std::cout << shape.name << ": " << text.size() / 1024 << " KB, " << 1000.0 * parse_time << " ms, "
+		<< 1e9 * parse_time / terms << " ns per term" << std::endl;
+}
+
+int main(int argc, const char* const* argv) {
+	int terms = argc > 1 ? std::stoi(argv[1]) : 1000000;
+
+	shape shapes[] =
+	{
+		{ "sum", generate_sum, count_left_terms },
+		{ "sum of products", generate_sum_of_products, count_product_terms },
+		{ "power chain", generate_power_chain, count_right_terms },
+		{ "nested parentheses", generate_nested_parentheses, count_nested_terms },
+		{ "condition", generate_condition, count_condition_terms },
+	};
+
+	try {
+		for (const auto& shape : shapes)
+			measure(shape, terms);
+	}
+	catch (std::exception* exception) {
+		std::cerr << exception->what() << std::endl;
+		delete exception;
+
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+// Measures the phases of the compiler separately on machine-generated programs of
+// several shapes and reports the throughput of every phase in MB of source per second.
+//
+//   phase_benchmark [scale]
+//
+// `scale` multiplies the number of assignments of every shape, 1 by default.
+// Parsing includes scanning, the other phases take the result of the previous one.
+// The generator rejects calls of user functions, so step2 is skipped for shapes with them.
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../parser.h"
+#include "../step1_tables_builder.h"
+#include "../step2_generator.h"
+#include "synthetic_program.h"
+
+struct shape
+{
+	const char* name;
+	synthetic_program_options options;
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void print_phase(const char* phase, double seconds, int repetitions, double megabytes) {
+	std::cout << "  " << phase << 1000.0 * seconds / repetitions << " ms ("
+		<< megabytes * repetitions / seconds << " MB/s)" << std::endl;
+}
+
+static void measure(const shape& shape, int repetitions) {
+	std::string text = generate_synthetic_program(shape.options);
+	double scan_time = 0.0;
+	double parse_time = 0.0;
+	double step1_time = 0.0;
+	double step2_time = 0.0;
+	size_t lexeme_count = 0;
+	size_t code_size = 0;
+
+	for (int i = 0; i < repetitions; i++) {
+		auto start = std::chrono::steady_clock::now();
+
+		for (scanner scanner(text); scanner.lexeme() != lexeme::Eof; scanner.next())
+			lexeme_count++;
+
+		scan_time += seconds_since(start);
+
+		start = std::chrono::steady_clock::now();
+		parser parser(text);
+		const ast_program* program = parser.parse_program();
+		parse_time += seconds_since(start);
+
+		start = std::chrono::steady_clock::now();
+		step1_tables_builder builder;
+		auto registry = builder.build(program);
+		step1_time += seconds_since(start);
+
+		if (shape.options.functions == 0) {
+			std::ostringstream code;
+			start = std::chrono::steady_clock::now();
+			step2_generator generator(registry, code);
+			generator.print_code();
+			step2_time += seconds_since(start);
+
+			code_size = code.str().size();
+		}
+
+		delete program;
+	}
+
+	double megabytes = text.size() / (1024.0 * 1024.0);
+	std::cout << shape.name << ": " << megabytes << " MB, " << shape.options.assignments << " assignments of "
+		<< shape.options.terms << " terms, depth " << shape.options.depth << ", "
+		<< shape.options.functions << " functions" << std::endl;
+	print_phase("scan:  ", scan_time, repetitions, megabytes);
+	std::cout << "         " << lexeme_count / repetitions << " lexemes" << std::endl;
+	print_phase("parse: ", parse_time, repetitions, megabytes);
+	print_phase("step1: ", step1_time, repetitions, megabytes);
+	if (shape.options.functions > 0) {
+		std::cout << "  step2: skipped, calls of user functions are not supported" << std::endl;
+
+		return;
+	}
+
+	print_phase("step2: ", step2_time, repetitions, megabytes);
+	std::cout << "         " << code_size / 1024 << " KB of LLVM IR" << std::endl;
+}
+
+int main(int argc, const char* const* argv) {
+	int scale = argc > 1 ? std::stoi(argv[1]) : 1;
+	int repetitions = 5;
+
+	shape shapes[] =
+	{
+		{ "many assignments", { 20000 * scale, 4, 0, 0 } },
+		{ "long lines", { 10 * scale, 10000, 0, 0 } },
+		{ "deep nesting", { 200 * scale, 4, 100, 0 } },
+		{ "many calls", { 2000 * scale, 30, 0, 200 } },
+	};
+
+	try {
+		for (const auto& shape : shapes)
+			measure(shape, repetitions);
+	}
+	catch (std::exception* exception) {
+		std::cerr << exception->what() << std::endl;
+		delete exception;
+
+		return 1;
+	}
+
+	return 0;
+}
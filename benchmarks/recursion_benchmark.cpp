@@ -0,0 +1,88 @@
+// Evaluates recursive functions with recursion depth in the millions on the bytecode
+// virtual machine and, when built with COMCALC_LLVM, on the JIT.
+//
+//   recursion_benchmark [depth]
+//
+// Tail calls and `long` sums and products of a self-call are lowered to loops, so
+// neither engine grows its stack with the depth.
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "../bytecode_compiler.h"
+#include "../bytecode_vm.h"
+#include "../jit_engine.h"
+#include "../parser.h"
+#include "../step1_tables_builder.h"
+
+struct recursion_case
+{
+	const char* name;
+	const char* text;
+};
+
+static const recursion_case cases[] = {
+	{ "tail call", "count(n, k) = if n = 0 then k else count(n - 1, k + n % 3)\nr = count(n, 0)\n" },
+	{ "branches", "walk(n, k) = if n = 0 then k else if n % 2 = 0 then walk(n - 1, k + 1) else walk(n - 1, k * 3 % 1009)\n"
+		"r = walk(n, 0)\n" },
+	{ "accumulator", "sum(n) = if n = 0 then 0 else n % 7 + sum(n - 1)\nr = sum(n)\n" },
+	{ "mixed types", "half(n, x) = if n = 0 then x else half(n - 1, x / 2 + 1)\nr = half(n, 0)\n" },
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void run(const recursion_case& recursion_case, long depth) {
+	parser parser(recursion_case.text);
+	const ast_program* program = parser.parse_program();
+
+	step1_tables_builder builder;
+	auto table_registry = builder.build(program);
+
+	std::map<std::string, value> inputs;
+	inputs["n"] = value(depth);
+
+	bytecode_compiler compiler;
+	bytecode_vm vm(compiler.compile(table_registry));
+
+	auto start = std::chrono::steady_clock::now();
+	auto outputs = vm.evaluate(inputs);
+	double vm_time = seconds_since(start);
+
+	std::cout << recursion_case.name << ": r = " << outputs["r"].to_string() << std::endl;
+	std::cout << "  vm:  " << 1000.0 * vm_time << " ms" << std::endl;
+
+#ifdef COMCALC_LLVM
+	jit_engine jit(table_registry);
+
+	start = std::chrono::steady_clock::now();
+	jit.evaluate(inputs);
+	double jit_time = seconds_since(start);
+
+	std::cout << "  jit: " << 1000.0 * jit_time << " ms" << std::endl;
+#endif
+
+	delete program;
+}
+
+int main(int argc, const char* const* argv) {
+	long depth = argc > 1 ? std::stol(argv[1]) : 10000000;
+
+	std::cout << "depth: " << depth << std::endl;
+
+	try {
+		for (auto i = std::begin(cases); i != std::end(cases); i++)
+			run(*i, depth);
+	}
+	catch (std::exception* exception) {
+		std::cerr << exception->what() << std::endl;
+		delete exception;
+
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,101 @@
+#!/bin/sh
+# Runs the code comcalc generates and the reference C programs over the same inputs
+# and prints their time and instructions per evaluation side by side.
+#
+#   runtime_benchmark.sh path/to/comcalc [-O2]
+#
+# Both sides go through the same opt and llc at the same level and are linked with
+# runtime_driver.c, which calls their main() over benchmarks/inputs/<program>.txt.
+# The reference C is compiled to unoptimized IR by clang when it is installed,
+# otherwise the reference .ll shipped next to it is used. Tools are taken from PATH,
+# or from the OPT, LLC, CC and CLANG variables.
+
+set -u
+
+if [ $# -lt 1 ]; then
+	echo "  Usage: runtime_benchmark.sh path/to/comcalc [-O2]" >&2
+	exit 2
+fi
+
+comcalc=$1
+level=${2:--O2}
+root=$(cd "$(dirname "$0")/.." && pwd)
+
+find_tool() {
+	for name in "$@"; do
+		if command -v "$name" >/dev/null 2>&1; then
+			echo "$name"
+			return
+		fi
+	done
+}
+
+OPT=${OPT:-$(find_tool opt opt-18 opt-17 opt-16 opt-15 opt-14)}
+LLC=${LLC:-$(find_tool llc llc-18 llc-17 llc-16 llc-15 llc-14)}
+CC=${CC:-cc}
+CLANG=${CLANG:-$(find_tool clang clang-18 clang-17 clang-16 clang-15 clang-14)}
+
+if [ -z "$OPT" ] || [ -z "$LLC" ]; then
+	echo "opt and llc are needed, set OPT and LLC." >&2
+	exit 2
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+"$CC" -O2 -c "$root/benchmarks/runtime_driver.c" -o "$work/driver.o" || exit 1
+
+# Builds $work/$2 from the IR in $1. Prints the error and fails if any step fails.
+build() {
+	# main() is renamed for the driver. The reference IR is unoptimized, its BOM and
+	# optnone would keep it from being optimized at the level.
+	sed -e '1s/^\xEF\xBB\xBF//' -e 's/@main(/@program_main(/' -e 's/ optnone//' -e 's/noinline //' "$1" > "$work/$2.renamed.ll" &&
+	"$OPT" "$level" "$work/$2.renamed.ll" -o "$work/$2.bc" 2> "$work/$2.error" &&
+	"$LLC" "$level" -relocation-model=pic "$work/$2.bc" -o "$work/$2.s" 2> "$work/$2.error" &&
+	"$CC" "$work/$2.s" "$work/driver.o" -o "$work/$2" -lm 2> "$work/$2.error"
+}
+
+# Prints a row of the table for the binary $work/$2 run over the inputs of program $1.
+run() {
+	# comcalc does not generate user functions yet, so fibonacci is rejected. That is
+	# a limit of the compiler, not of the harness.
+	if [ ! -x "$work/$2" ] && grep -q "not supported" "$work/$2.error" 2> /dev/null; then
+		printf "%-10s %-10s unsupported: %s\n" "$1" "$3" "$(head -n 1 "$work/$2.error" | cut -c 1-60)"
+		return
+	fi
+
+	if [ ! -x "$work/$2" ]; then
+		reason=$(grep -m 1 -i -e "error" -e "undefined" "$work/$2.error" || head -n 1 "$work/$2.error")
+		printf "%-10s %-10s build failed: %s\n" "$1" "$3" "$(echo "$reason" | cut -c 1-60)"
+		return
+	fi
+
+	# Machine instructions of all the functions, without directives and labels.
+	code_size=$(grep -c "^	[a-z]" "$work/$2.s")
+
+	set -- "$1" "$2" "$3" $("$work/$2" "$root/benchmarks/inputs/$1.txt")
+	printf "%-10s %-10s %10s %12s %10s %s\n" "$1" "$3" "$4" "$5" "$code_size" "$6"
+}
+
+printf "%-10s %-10s %10s %12s %10s %s\n" program code ns/eval instr/eval code checksum
+
+for program in quadratic fibonacci; do
+	# The reference programs print only x1 and x2 of quadratic.comcalc.
+	case $program in
+		quadratic) outputs="--outputs x1,x2" ;;
+		*) outputs="" ;;
+	esac
+
+	"$comcalc" "$root/$program.comcalc" "$work/$program.comcalc.ll" $outputs > /dev/null 2> "$work/$program.comcalc.error" &&
+		build "$work/$program.comcalc.ll" "$program.comcalc"
+
+	if [ -n "$CLANG" ]; then
+		"$CLANG" -O0 -Xclang -disable-O0-optnone -S -emit-llvm "$root/$program.c" -o "$work/$program.c.ll" 2> /dev/null &&
+			build "$work/$program.c.ll" "$program.c"
+	else
+		build "$root/$program.ll" "$program.c"
+	fi
+
+	run "$program" "$program.comcalc" comcalc
+	run "$program" "$program.c" reference
+done
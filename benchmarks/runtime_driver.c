@@ -0,0 +1,227 @@
+// Calls main() of a compiled program, renamed to program_main(), over a fixed input set.
+// scanf() and printf() are replaced, so an evaluation costs the computation and a few
+// calls only: scanf() takes the next number of the current input row, and printf()
+// adds the number it prints to a checksum, which shows whether two programs agree.
+//
+//   program inputs.txt [seconds]
+//
+// Every line of inputs.txt holds the inputs of one evaluation in the order they are
+// read. The input set is repeated for at least `seconds` (0.5 by default). Prints
+// nanoseconds and instructions per evaluation and the checksum of one pass over the
+// set, or `n/a` for instructions if hardware counters are not available.
+
+#define _GNU_SOURCE
+
+#include <linux/perf_event.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+void program_main(void);
+
+#define max_values 65536
+#define max_rows 4096
+
+static double values[max_values];
+static int row_starts[max_rows + 1];
+static int row_count;
+static int next_value;
+static int row_end;
+static double checksum;
+
+static int read_input(const char* format, va_list arguments) {
+	if (next_value == row_end)
+		return EOF;
+
+	double value = values[next_value++];
+
+	// Formats are "%lf", "%ld" and "%d", optionally followed by separators to skip.
+	if (strncmp(format, "%lf", 3) == 0 || strncmp(format, "%f", 2) == 0)
+		*va_arg(arguments, double*) = value;
+	else if (strncmp(format, "%ld", 3) == 0 || strncmp(format, "%lld", 4) == 0)
+		*va_arg(arguments, long*) = (long)value;
+	else
+		*va_arg(arguments, int*) = (int)value;
+
+	return 1;
+}
+
+// The replacements get their symbol names through asm labels, because <stdio.h> may
+// redirect or wrap the names it declares.
+int driver_scanf(const char* format, ...) __asm__("scanf");
+int driver_isoc99_scanf(const char* format, ...) __asm__("__isoc99_scanf");
+int driver_printf(const char* format, ...) __asm__("printf");
+int driver_puts(const char* text) __asm__("puts");
+int driver_putchar(int c) __asm__("putchar");
+
+int driver_scanf(const char* format, ...) {
+	va_list arguments;
+	va_start(arguments, format);
+	int result = read_input(format, arguments);
+	va_end(arguments);
+
+	return result;
+}
+
+// glibc redirects scanf() of ISO C programs to this name.
+int driver_isoc99_scanf(const char* format, ...) {
+	va_list arguments;
+	va_start(arguments, format);
+	int result = read_input(format, arguments);
+	va_end(arguments);
+
+	return result;
+}
+
+int driver_printf(const char* format, ...) {
+	const char* conversion = strchr(format, '%');
+	if (conversion == NULL)
+		return 0;
+
+	va_list arguments;
+	va_start(arguments, format);
+
+	if (strncmp(conversion, "%lf", 3) == 0 || strncmp(conversion, "%f", 2) == 0)
+		checksum += va_arg(arguments, double);
+	else if (strncmp(conversion, "%ld", 3) == 0)
+		checksum += (double)va_arg(arguments, long);
+	else
+		checksum += (double)va_arg(arguments, int);
+
+	va_end(arguments);
+
+	return 1;
+}
+
+// Compilers turn printf() of constant strings into these.
+int driver_puts(const char* text) {
+	return 1;
+}
+
+int driver_putchar(int c) {
+	return c;
+}
+
+static void read_inputs(const char* path) {
+	FILE* file = fopen(path, "r");
+	if (file == NULL) {
+		fprintf(stderr, "Can't read inputs `%s`.\n", path);
+		exit(2);
+	}
+
+	char line[4096];
+	int value_count = 0;
+
+	while (row_count < max_rows && fgets(line, sizeof(line), file) != NULL) {
+		char* position = line;
+		char* end;
+		int start = value_count;
+
+		for (double value = strtod(position, &end); end != position; value = strtod(position, &end)) {
+			if (value_count == max_values)
+				break;
+
+			values[value_count++] = value;
+			position = end;
+		}
+
+		if (value_count > start)
+			row_starts[row_count++] = start;
+	}
+
+	row_starts[row_count] = value_count;
+	fclose(file);
+}
+
+static void run_inputs(void) {
+	for (int i = 0; i < row_count; i++) {
+		next_value = row_starts[i];
+		row_end = row_starts[i + 1];
+
+		program_main();
+	}
+}
+
+static double seconds_since(const struct timespec* start) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+// Returns -1 if the counter can't be opened, e.g. in containers.
+static int open_instruction_counter(void) {
+	struct perf_event_attr attributes;
+	memset(&attributes, 0, sizeof(attributes));
+	attributes.size = sizeof(attributes);
+	attributes.type = PERF_TYPE_HARDWARE;
+	attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+	attributes.disabled = 1;
+	attributes.exclude_kernel = 1;
+	attributes.exclude_hv = 1;
+
+	return (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "  Usage: program inputs.txt [seconds]\n");
+
+		return 2;
+	}
+
+	read_inputs(argv[1]);
+	double seconds = argc > 2 ? atof(argv[2]) : 0.5;
+
+	if (row_count == 0) {
+		fprintf(stderr, "No inputs in `%s`.\n", argv[1]);
+
+		return 2;
+	}
+
+	// The first pass warms caches up and gives the checksum.
+	checksum = 0.0;
+	run_inputs();
+	double pass_checksum = checksum;
+
+	int counter = open_instruction_counter();
+	if (counter >= 0) {
+		ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+		ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	long evaluations = 0;
+	double elapsed;
+
+	do {
+		run_inputs();
+		evaluations += row_count;
+		elapsed = seconds_since(&start);
+	} while (elapsed < seconds);
+
+	uint64_t instructions = 0;
+	if (counter >= 0) {
+		ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(counter, &instructions, sizeof(instructions)) != sizeof(instructions))
+			counter = -1;
+
+		close(counter);
+	}
+
+	fprintf(stdout, "%.1f ", 1e9 * elapsed / evaluations);
+	if (counter >= 0)
+		fprintf(stdout, "%.1f ", (double)instructions / evaluations);
+	else
+		fprintf(stdout, "n/a ");
+	fprintf(stdout, "%.17g\n", pass_checksum);
+
+	return 0;
+}
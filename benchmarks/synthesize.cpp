@@ -0,0 +1,22 @@
+// Writes a machine-generated program to stdout, to benchmark the whole compiler.
+//
+//   synthesize [assignments] [terms] [depth] [functions]
+//
+// See synthetic_program.h for the meaning of the sizes.
+
+#include <iostream>
+#include <string>
+
+#include "synthetic_program.h"
+
+int main(int argc, const char* const* argv) {
+	synthetic_program_options options;
+	options.assignments = argc > 1 ? std::stoi(argv[1]) : options.assignments;
+	options.terms = argc > 2 ? std::stoi(argv[2]) : options.terms;
+	options.depth = argc > 3 ? std::stoi(argv[3]) : options.depth;
+	options.functions = argc > 4 ? std::stoi(argv[4]) : options.functions;
+
+	std::cout << generate_synthetic_program(options);
+
+	return 0;
+}
@@ -0,0 +1,58 @@
+#include <sstream>
+
+#include "synthetic_program.h"
+
+static void print_term(std::ostream& out, int assignment, int term, const synthetic_program_options& options) {
+	for (int i = 0; i < options.depth; i++)
+		out << "(c" << i % 3 << (i % 2 == 0 ? " - " : " * ");
+
+	switch (term % 3) {
+	case 0:
+		out << "a" << term % 7 << " * " << term << " / (b" << term % 5 << " + 1.5)";
+		break;
+	case 1:
+		if (assignment > 0)
+			out << "y" << assignment - 1 << " / " << term + 2;
+		else
+			out << "sqrt(b" << term % 5 << " ^ 2)";
+		break;
+	default:
+		if (options.functions > 0)
+			out << "f" << term % options.functions << "(a" << term % 7 << " - " << term << ")";
+		else
+			out << "exp(a" << term % 7 << " / " << term + 1 << ")";
+		break;
+	}
+
+	for (int i = 0; i < options.depth; i++)
+		out << ")";
+}
+
+std::string generate_synthetic_program(const synthetic_program_options& options) {
+	std::ostringstream out;
+
+	for (int i = 0; i < options.functions; i++) {
+		if (i == 0)
+			out << "f0(x) = x * 2.5 + a0" << std::endl;
+		else
+			out << "f" << i << "(x) = f" << i - 1 << "(x - 1) * 0.5 + x" << std::endl;
+	}
+
+	for (int i = 0; i < options.assignments; i++) {
+		out << "y" << i << " = ";
+
+		for (int j = 0; j < options.terms; j++) {
+			if (j > 0)
+				out << (j % 2 == 0 ? " + " : " - ");
+
+			print_term(out, i, j, options);
+		}
+
+		if (options.terms == 0)
+			out << "a0";
+
+		out << std::endl;
+	}
+
+	return out.str();
+}
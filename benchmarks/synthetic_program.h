@@ -0,0 +1,28 @@
+#ifndef __SYNTHETIC_PROGRAM_H__
+#define __SYNTHETIC_PROGRAM_H__
+
+#include <string>
+
+// Shape of a machine-generated program. Every dimension is scaled on its own.
+struct synthetic_program_options
+{
+	// Number of assignment lines. Every assignment reads the previous one.
+	int assignments = 1000;
+
+	// Terms summed in every assignment, i.e. the length of a line.
+	int terms = 10;
+
+	// Depth of parentheses every term is nested in.
+	int depth = 0;
+
+	// Number of user functions. Every function calls the previous one, and every
+	// third term calls one of them.
+	int functions = 0;
+};
+
+// Returns the text of a valid program of the shape. Inputs are among `a0`..`a6`,
+// `b0`..`b4` and `c0`..`c2`, all of them double. Which of them are read depends on
+// the shape, e.g. 4 terms read only `a0`, `a2` and `a3` of the `a` inputs.
+std::string generate_synthetic_program(const synthetic_program_options& options);
+
+#endif
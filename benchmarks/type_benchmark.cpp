@@ -0,0 +1,90 @@
+// Runs the passes which ask operators for their types at every level on left-deep
+// chains `i + 1 - a + 1 ...` of growing length, and reports the time per term.
+// The time per term stays flat only while a type query costs the same at any depth.
+//
+//   type_benchmark [terms]
+//
+// Chains of `terms` / 8, `terms` / 4, `terms` / 2 and `terms` terms are measured,
+// 8000 by default. The passes are recursive, so `terms` is bounded by the stack.
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../constant_folder.h"
+#include "../parser.h"
+#include "../step1_tables_builder.h"
+#include "../step2_generator.h"
+
+static std::string generate_chain(int terms) {
+	std::string text = "y = i";
+	for (int j = 1; j < terms; j++) {
+		text += j % 2 == 0 ? " - " : " + ";
+		text += j % 4 == 3 ? "a" : "1";
+	}
+
+	return text + "\n";
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void print_phase(const char* phase, double seconds, int repetitions, int terms) {
+	std::cout << "  " << phase << 1000.0 * seconds / repetitions << " ms ("
+		<< 1e9 * seconds / repetitions / terms << " ns per term)" << std::endl;
+}
+
+static void measure(int terms, int repetitions) {
+	std::string text = generate_chain(terms);
+	double step1_time = 0.0;
+	double fold_time = 0.0;
+	double step2_time = 0.0;
+
+	for (int i = 0; i < repetitions; i++) {
+		parser parser(text);
+		const ast_program* program = parser.parse_program();
+
+		auto start = std::chrono::steady_clock::now();
+		step1_tables_builder builder;
+		auto registry = builder.build(program);
+		step1_time += seconds_since(start);
+
+		start = std::chrono::steady_clock::now();
+		constant_folder folder(program->arena());
+		auto folded_registry = folder.fold(registry);
+		fold_time += seconds_since(start);
+
+		std::ostringstream code;
+		start = std::chrono::steady_clock::now();
+		step2_generator generator(folded_registry, code);
+		generator.print_code();
+		step2_time += seconds_since(start);
+
+		delete program;
+	}
+
+	std::cout << terms << " terms:" << std::endl;
+	print_phase("step1: ", step1_time, repetitions, terms);
+	print_phase("fold:  ", fold_time, repetitions, terms);
+	print_phase("step2: ", step2_time, repetitions, terms);
+}
+
+int main(int argc, const char* const* argv) {
+	int terms = argc > 1 ? std::stoi(argv[1]) : 8000;
+	int repetitions = 5;
+
+	try {
+		for (int length = terms / 8; length <= terms; length *= 2)
+			measure(length, repetitions);
+	}
+	catch (std::exception* exception) {
+		std::cerr << exception->what() << std::endl;
+		delete exception;
+
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef __BYTECODE_H__
+#define __BYTECODE_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "expression.h"
+#include "value.h"
+
+// Instructions are typed, so the virtual machine never checks types at run time.
+// Operands `a`, `b` and `c` are register numbers relative to the frame of the
+// current function unless stated otherwise.
+enum class opcode
+{
+	LoadConstant,     // a = constants[b]
+	LoadGlobal,       // a = globals[b]
+	Move,             // a = b
+	LongToDouble,     // a = (double)b
+	DoubleToLong,     // a = (long)b
+	AddLong,          // a = b + c
+	SubtractLong,
+	MultiplyLong,
+	DivideLong,
+	ReminderLong,
+	AddDouble,
+	SubtractDouble,
+	MultiplyDouble,
+	DivideDouble,
+	ReminderDouble,
+	PowDouble,
+	NegativeLong,     // a = -b
+	NegativeDouble,
+	LessLong,         // a = b < c ? 1 : 0
+	LessEqualLong,
+	GreaterLong,
+	GreaterEqualLong,
+	EqualLong,
+	NotEqualLong,
+	LessDouble,
+	LessEqualDouble,
+	GreaterDouble,
+	GreaterEqualDouble,
+	EqualDouble,
+	NotEqualDouble,
+	Not,              // a = b ? 0 : 1
+	Jump,             // goto a
+	JumpIfFalse,      // if (!a) goto b
+	JumpIfTrue,       // if (a) goto b
+	CallUnary,        // a = unary_functions[c](b)
+	CallBinary,       // a = binary_functions[c](b, b + 1)
+	Call,             // a = functions[c](b, b + 1, ...)
+	Return,           // return a
+};
+
+struct instruction
+{
+	::opcode opcode;
+	int a;
+	int b;
+	int c;
+};
+
+union slot
+{
+	long long_value;
+	double double_value;
+};
+
+struct bytecode_function
+{
+	std::string name;
+	expression_type result_type;
+	std::vector<expression_type> parameter_types;
+	int parameter_count;
+	int register_count;
+	std::vector<instruction> code;
+};
+
+// functions[0] is the main chunk executing assignments. Its first registers are the
+// static variables, so they are globals visible from every function.
+struct bytecode_program
+{
+	std::vector<bytecode_function> functions;
+	std::vector<slot> constants;
+	std::vector<unary_function> unary_functions;
+	std::vector<binary_function> binary_functions;
+	std::map<std::string, int> globals;
+	std::map<std::string, expression_type> global_types;
+	std::map<std::string, expression_type> input_variables;
+	std::map<std::string, expression_type> output_variables;
+};
+
+#endif
@@ -0,0 +1,482 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "bytecode_compiler.h"
+
+bytecode_program bytecode_compiler::compile(const table_registry& table_registry) {
+	_program = bytecode_program();
+	_function_indices.clear();
+	_unary_function_indices.clear();
+	_binary_function_indices.clear();
+
+	auto input_variables = table_registry.input_variables();
+	auto output_variables = table_registry.output_variables();
+
+	_program.global_types = input_variables;
+	_program.global_types.insert(output_variables.cbegin(), output_variables.cend());
+
+	for (auto i = _program.global_types.cbegin(); i != _program.global_types.cend(); i++) {
+		int index = (int)_program.globals.size();
+		_program.globals[i->first] = index;
+
+		if (output_variables.find(i->first) == output_variables.end())
+			_program.input_variables.insert(*i);
+
+		if (input_variables.find(i->first) == input_variables.end())
+			_program.output_variables.insert(*i);
+	}
+
+	auto functions = table_registry.functions();
+	_program.functions.resize(functions.size() + 1);
+	for (size_t i = 0; i < functions.size(); i++) {
+		_function_indices[functions[i]->name()] = (int)i + 1;
+
+		auto parameters = functions[i]->parameters();
+		for (auto j = parameters.cbegin(); j != parameters.cend(); j++)
+			_program.functions[i + 1].parameter_types.push_back(j->second);
+	}
+
+	compile_main(table_registry.assignments());
+
+	for (size_t i = 0; i < functions.size(); i++)
+		compile_function(functions[i], _program.functions[i + 1]);
+
+	return _program;
+}
+
+void bytecode_compiler::compile_main(const std::vector<const ast_assignment*>& assignments) {
+	_function = &_program.functions[0];
+	_function->name = "main";
+	_function->result_type = expression_type::Long;
+	_function->parameter_count = 0;
+	_function->register_count = (int)_program.globals.size();
+	_next_register = _function->register_count;
+	_parameters.clear();
+
+	for (auto i = assignments.cbegin(); i != assignments.cend(); i++)
+		(*i)->accept(*this);
+
+	emit(opcode::Return, 0);
+}
+
+void bytecode_compiler::compile_function(const ast_function* function, bytecode_function& compiled_function) {
+	_function = &compiled_function;
+	_function->name = function->name();
+	_function->result_type = function->expression()->type();
+	_function->parameter_count = (int)function->parameters().size();
+	_function->register_count = _function->parameter_count;
+	_next_register = _function->register_count;
+	_parameters.clear();
+
+	for (size_t i = 0; i < function->parameters().size(); i++) {
+		auto parameter = function->parameters()[i];
+
+		_parameters[parameter.first] = operand{ (int)i, parameter.second, false };
+	}
+
+	tail_recursion recursion(function);
+	if (recursion.is_loop()) {
+		compile_loop(recursion, function);
+
+		return;
+	}
+
+	auto result = convert(compile(function->expression()), _function->result_type);
+	emit(opcode::Return, result.register_index);
+}
+
+int bytecode_compiler::emit(opcode opcode, int a, int b, int c) {
+	_function->code.push_back(instruction{ opcode, a, b, c });
+
+	return (int)_function->code.size() - 1;
+}
+
+// Jumps are emitted before their target is known, so the target is set later.
+void bytecode_compiler::patch_jump(int instruction_index) {
+	auto& jump = _function->code[instruction_index];
+	int target = (int)_function->code.size();
+
+	if (jump.opcode == opcode::Jump)
+		jump.a = target;
+	else
+		jump.b = target;
+}
+
+int bytecode_compiler::allocate_register() {
+	int result = _next_register++;
+	_function->register_count = std::max(_function->register_count, _next_register);
+
+	return result;
+}
+
+// Temporaries allocated after the first consumed one belong to the consumed
+// subexpressions, so all of them are released together.
+void bytecode_compiler::release(const std::vector<operand>& operands) {
+	for (auto i = operands.cbegin(); i != operands.cend(); i++) {
+		if (i->is_temporary)
+			_next_register = std::min(_next_register, i->register_index);
+	}
+}
+
+bytecode_compiler::operand bytecode_compiler::pop_operand() {
+	auto result = _operands.top();
+	_operands.pop();
+
+	return result;
+}
+
+bytecode_compiler::operand bytecode_compiler::compile(const ast_node* node) {
+	node->accept(*this);
+
+	return pop_operand();
+}
+
+bytecode_compiler::operand bytecode_compiler::convert(operand value, expression_type type) {
+	if (value.type == type)
+		return value;
+
+	int index = value.is_temporary ? value.register_index : allocate_register();
+	emit(type == expression_type::Double ? opcode::LongToDouble : opcode::DoubleToLong, index, value.register_index);
+
+	return operand{ index, type, true };
+}
+
+void bytecode_compiler::move(int register_index, operand value) {
+	if (value.register_index != register_index)
+		emit(opcode::Move, register_index, value.register_index);
+}
+
+int bytecode_compiler::get_unary_function_index(const std::string& name, unary_function function) {
+	auto index = _unary_function_indices.find(name);
+	if (index != _unary_function_indices.end())
+		return index->second;
+
+	_program.unary_functions.push_back(function);
+
+	return _unary_function_indices[name] = (int)_program.unary_functions.size() - 1;
+}
+
+int bytecode_compiler::get_binary_function_index(const std::string& name, binary_function function) {
+	auto index = _binary_function_indices.find(name);
+	if (index != _binary_function_indices.end())
+		return index->second;
+
+	_program.binary_functions.push_back(function);
+
+	return _binary_function_indices[name] = (int)_program.binary_functions.size() - 1;
+}
+
+void bytecode_compiler::visit_assignment(const ast_assignment* assignment) {
+	int global = _program.globals[assignment->name()];
+	auto result = convert(compile(assignment->expression()), _program.global_types[assignment->name()]);
+
+	move(global, result);
+	release({ result });
+}
+
+void bytecode_compiler::visit_long(const ast_long* _long) {
+	slot constant;
+	constant.long_value = _long->value();
+	_program.constants.push_back(constant);
+
+	int index = allocate_register();
+	emit(opcode::LoadConstant, index, (int)_program.constants.size() - 1);
+
+	_operands.push(operand{ index, expression_type::Long, true });
+}
+
+void bytecode_compiler::visit_double(const ast_double* _double) {
+	slot constant;
+	constant.double_value = _double->value();
+	_program.constants.push_back(constant);
+
+	int index = allocate_register();
+	emit(opcode::LoadConstant, index, (int)_program.constants.size() - 1);
+
+	_operands.push(operand{ index, expression_type::Double, true });
+}
+
+void bytecode_compiler::visit_variable(const ast_variable* variable) {
+	// A read of a parameter has a type of its own, the value is converted to it.
+	auto parameter = _parameters.find(variable->name());
+	if (parameter != _parameters.end()) {
+		_operands.push(convert(parameter->second, variable->type()));
+
+		return;
+	}
+
+	int global = _program.globals[variable->name()];
+	auto type = _program.global_types[variable->name()];
+
+	if (_function == &_program.functions[0]) {
+		_operands.push(operand{ global, type, false });
+
+		return;
+	}
+
+	int index = allocate_register();
+	emit(opcode::LoadGlobal, index, global);
+
+	_operands.push(operand{ index, type, true });
+}
+
+// Arguments are placed into consecutive registers, which become the first
+// registers (parameters) of the called function frame.
+void bytecode_compiler::visit_call(const ast_call* call) {
+	auto unary_standard_function = find_unary_standard_function(call->name());
+	auto binary_standard_function = find_binary_standard_function(call->name());
+	auto function_index = _function_indices.find(call->name());
+
+	bool is_standard_function = unary_standard_function != nullptr || binary_standard_function != nullptr;
+	if (!is_standard_function && function_index == _function_indices.end())
+		throw new std::runtime_error("Function `" + call->name() + "` is not declared.");
+
+	int base = _next_register;
+	for (size_t i = 0; i < call->parameters().size(); i++)
+		allocate_register();
+
+	for (size_t i = 0; i < call->parameters().size(); i++) {
+		auto type = expression_type::Double;
+		if (!is_standard_function)
+			type = _program.functions[function_index->second].parameter_types[i];
+
+		auto argument = convert(compile(call->parameters()[i]), type);
+		move(base + (int)i, argument);
+		release({ argument });
+	}
+
+	if (unary_standard_function != nullptr)
+		emit(opcode::CallUnary, base, base, get_unary_function_index(call->name(), unary_standard_function));
+	else if (binary_standard_function != nullptr)
+		emit(opcode::CallBinary, base, base, get_binary_function_index(call->name(), binary_standard_function));
+	else
+		emit(opcode::Call, base, base, function_index->second);
+
+	_next_register = base;
+	int index = allocate_register();
+
+	_operands.push(operand{ index, call->type(), true });
+}
+
+void bytecode_compiler::visit_unary_operator(const ast_unary_operator* unary_operator) {
+	auto value = compile(unary_operator->operand());
+
+	if (unary_operator->operation() == unary_operation::Positive) {
+		_operands.push(value);
+
+		return;
+	}
+
+	release({ value });
+	int index = allocate_register();
+	emit(value.type == expression_type::Double ? opcode::NegativeDouble : opcode::NegativeLong, index, value.register_index);
+
+	_operands.push(operand{ index, value.type, true });
+}
+
+static opcode get_binary_opcode(binary_operation operation, expression_type type) {
+	bool is_double = type == expression_type::Double;
+
+	switch (operation) {
+	case binary_operation::Add:
+		return is_double ? opcode::AddDouble : opcode::AddLong;
+	case binary_operation::Subtract:
+		return is_double ? opcode::SubtractDouble : opcode::SubtractLong;
+	case binary_operation::Multiply:
+		return is_double ? opcode::MultiplyDouble : opcode::MultiplyLong;
+	case binary_operation::Divide:
+		return is_double ? opcode::DivideDouble : opcode::DivideLong;
+	case binary_operation::Reminder:
+		return is_double ? opcode::ReminderDouble : opcode::ReminderLong;
+	case binary_operation::Pow:
+		return opcode::PowDouble;
+	}
+
+	throw new std::runtime_error("Invalid binary operation.");
+}
+
+void bytecode_compiler::visit_binary_operator(const ast_binary_operator* binary_operator) {
+	auto type = binary_operator->type();
+	auto left = convert(compile(binary_operator->left()), type);
+	auto right = convert(compile(binary_operator->right()), type);
+
+	release({ left, right });
+	int index = allocate_register();
+	emit(get_binary_opcode(binary_operator->operation(), type), index, left.register_index, right.register_index);
+
+	_operands.push(operand{ index, type, true });
+}
+
+void bytecode_compiler::visit_logical_binary_operator(const ast_logical_binary_operator* logical_binary_operator) {
+	auto left = compile(logical_binary_operator->left());
+	release({ left });
+	int index = allocate_register();
+	move(index, left);
+
+	bool is_or = logical_binary_operator->operation() == "or";
+	int jump = emit(is_or ? opcode::JumpIfTrue : opcode::JumpIfFalse, index, 0);
+
+	auto right = compile(logical_binary_operator->right());
+	move(index, right);
+	release({ right });
+	patch_jump(jump);
+
+	_operands.push(operand{ index, expression_type::Long, true });
+}
+
+void bytecode_compiler::visit_logical_not_operator(const ast_logical_not_operator* logical_not_operator) {
+	auto value = compile(logical_not_operator->operand());
+	release({ value });
+	int index = allocate_register();
+	emit(opcode::Not, index, value.register_index);
+
+	_operands.push(operand{ index, expression_type::Long, true });
+}
+
+static opcode get_comparison_opcode(const std::string& operation, expression_type type) {
+	bool is_double = type == expression_type::Double;
+
+	if (operation == "<")
+		return is_double ? opcode::LessDouble : opcode::LessLong;
+
+	if (operation == "<=")
+		return is_double ? opcode::LessEqualDouble : opcode::LessEqualLong;
+
+	if (operation == ">")
+		return is_double ? opcode::GreaterDouble : opcode::GreaterLong;
+
+	if (operation == ">=")
+		return is_double ? opcode::GreaterEqualDouble : opcode::GreaterEqualLong;
+
+	if (operation == "=")
+		return is_double ? opcode::EqualDouble : opcode::EqualLong;
+
+	if (operation == "<>")
+		return is_double ? opcode::NotEqualDouble : opcode::NotEqualLong;
+
+	throw new std::runtime_error("Invalid comparison operation `" + operation + "`.");
+}
+
+void bytecode_compiler::visit_condition(const ast_condition* condition) {
+	auto type = expression_type::Long;
+	if (condition->left()->type() == expression_type::Double || condition->right()->type() == expression_type::Double)
+		type = expression_type::Double;
+
+	auto left = convert(compile(condition->left()), type);
+	auto right = convert(compile(condition->right()), type);
+
+	release({ left, right });
+	int index = allocate_register();
+	emit(get_comparison_opcode(condition->operation(), type), index, left.register_index, right.register_index);
+
+	_operands.push(operand{ index, expression_type::Long, true });
+}
+
+void bytecode_compiler::visit_if_then_else(const ast_if_then_else* if_then_else) {
+	auto type = if_then_else->type();
+
+	auto condition = compile(if_then_else->logical_expression());
+	int else_jump = emit(opcode::JumpIfFalse, condition.register_index, 0);
+	release({ condition });
+	int index = allocate_register();
+
+	auto then_value = convert(compile(if_then_else->then_expression()), type);
+	move(index, then_value);
+	release({ then_value });
+	int end_jump = emit(opcode::Jump, 0);
+
+	patch_jump(else_jump);
+	auto else_value = convert(compile(if_then_else->else_expression()), type);
+	move(index, else_value);
+	release({ else_value });
+	patch_jump(end_jump);
+
+	_operands.push(operand{ index, type, true });
+}
+
+// Leaves of the body return, tail self-calls move the arguments into the parameter
+// registers and jump back to the start of the body.
+void bytecode_compiler::compile_loop(const tail_recursion& recursion, const ast_function* function) {
+	if (recursion.has_accumulator()) {
+		slot identity;
+		identity.long_value = recursion.accumulator_operation() == binary_operation::Add ? 0 : 1;
+		_program.constants.push_back(identity);
+
+		_accumulator = allocate_register();
+		emit(opcode::LoadConstant, _accumulator, (int)_program.constants.size() - 1);
+	}
+
+	_loop_start = (int)_function->code.size();
+
+	std::vector<expression_type> types;
+	compile_tail(recursion, function->expression(), types);
+}
+
+void bytecode_compiler::compile_tail(const tail_recursion& recursion, const ast_expression* expression, std::vector<expression_type>& types) {
+	auto result_type = _function->result_type;
+	bool is_exact = std::all_of(types.cbegin(), types.cend(), [result_type](expression_type type) { return type == result_type; });
+	auto tail = recursion.classify(expression, is_exact);
+
+	if (tail.kind == tail_kind::Branch) {
+		auto condition = compile(tail.branch->logical_expression());
+		int else_jump = emit(opcode::JumpIfFalse, condition.register_index, 0);
+		release({ condition });
+
+		types.push_back(tail.branch->type());
+		compile_tail(recursion, tail.branch->then_expression(), types);
+		patch_jump(else_jump);
+		compile_tail(recursion, tail.branch->else_expression(), types);
+		types.pop_back();
+
+		return;
+	}
+
+	auto accumulator_opcode = get_binary_opcode(recursion.accumulator_operation(), expression_type::Long);
+
+	if (tail.kind == tail_kind::Value) {
+		auto result = compile(expression);
+		for (auto i = types.crbegin(); i != types.crend(); i++)
+			result = convert(result, *i);
+
+		result = convert(result, result_type);
+
+		if (recursion.has_accumulator()) {
+			release({ result });
+			int index = allocate_register();
+			emit(accumulator_opcode, index, _accumulator, result.register_index);
+			result = operand{ index, result_type, true };
+		}
+
+		emit(opcode::Return, result.register_index);
+		release({ result });
+
+		return;
+	}
+
+	// The operand and the arguments are computed from the current parameters before any of them changes.
+	int base = _next_register;
+	int argument_count = (int)tail.call->parameters().size();
+	for (int i = 0; i <= argument_count; i++)
+		allocate_register();
+
+	if (tail.kind == tail_kind::Accumulate) {
+		auto value = convert(compile(tail.operand), expression_type::Long);
+		move(base + argument_count, value);
+		release({ value });
+	}
+
+	for (int i = 0; i < argument_count; i++) {
+		auto argument = convert(compile(tail.call->parameters()[i]), _function->parameter_types[i]);
+		move(base + i, argument);
+		release({ argument });
+	}
+
+	if (tail.kind == tail_kind::Accumulate)
+		emit(accumulator_opcode, _accumulator, _accumulator, base + argument_count);
+
+	for (int i = 0; i < argument_count; i++)
+		emit(opcode::Move, i, base + i);
+
+	emit(opcode::Jump, _loop_start);
+	_next_register = base;
+}
@@ -0,0 +1,92 @@
+#ifndef __BYTECODE_COMPILER_H__
+#define __BYTECODE_COMPILER_H__
+
+#include <map>
+#include <stack>
+#include <string>
+#include <vector>
+
+#include "ast.h"
+#include "bytecode.h"
+#include "table_registry.h"
+#include "tail_recursion.h"
+
+class bytecode_compiler : private visitor
+{
+public:
+	bytecode_program compile(const table_registry& table_registry);
+
+private:
+	// Result of an expression: a register of the current frame. Temporary registers
+	// are allocated as a stack and released when the operand is consumed.
+	struct operand
+	{
+		int register_index;
+		expression_type type;
+		bool is_temporary;
+	};
+
+	bytecode_program _program;
+	std::map<std::string, int> _function_indices;
+	std::map<std::string, int> _unary_function_indices;
+	std::map<std::string, int> _binary_function_indices;
+	std::map<std::string, operand> _parameters;
+	bytecode_function* _function;
+	int _next_register;
+	int _loop_start;
+	int _accumulator;
+	std::stack<operand> _operands;
+
+	void compile_main(const std::vector<const ast_assignment*>& assignments);
+
+	void compile_function(const ast_function* function, bytecode_function& compiled_function);
+
+	void compile_loop(const tail_recursion& recursion, const ast_function* function);
+
+	// `types` are types of the enclosing branches, the outermost first.
+	void compile_tail(const tail_recursion& recursion, const ast_expression* expression, std::vector<expression_type>& types);
+
+	int emit(opcode opcode, int a, int b = 0, int c = 0);
+
+	void patch_jump(int instruction_index);
+
+	int allocate_register();
+
+	void release(const std::vector<operand>& operands);
+
+	operand pop_operand();
+
+	operand compile(const ast_node* node);
+
+	operand convert(operand value, expression_type type);
+
+	void move(int register_index, operand value);
+
+	int get_unary_function_index(const std::string& name, unary_function function);
+
+	int get_binary_function_index(const std::string& name, binary_function function);
+
+	virtual void visit_assignment(const ast_assignment* assignment);
+
+	virtual void visit_long(const ast_long* _long);
+
+	virtual void visit_double(const ast_double* _double);
+
+	virtual void visit_variable(const ast_variable* variable);
+
+	virtual void visit_call(const ast_call* call);
+
+	virtual void visit_unary_operator(const ast_unary_operator* unary_operator);
+
+	virtual void visit_binary_operator(const ast_binary_operator* binary_operator);
+
+	virtual void visit_logical_binary_operator(const ast_logical_binary_operator* logical_binary_operator);
+
+	virtual void visit_logical_not_operator(const ast_logical_not_operator* logical_not_operator);
+
+	virtual void visit_condition(const ast_condition* condition);
+
+	virtual void visit_if_then_else(const ast_if_then_else* if_then_else);
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include <cmath>
+#include <stdexcept>
+
+#include "bytecode_vm.h"
+
+bytecode_vm::bytecode_vm(const bytecode_program& program) : _program(program) {
+	_global_types.resize(_program.globals.size());
+	for (auto i = _program.globals.cbegin(); i != _program.globals.cend(); i++)
+		_global_types[i->second] = _program.global_types[i->first];
+
+	_registers.resize(_program.functions[0].register_count);
+}
+
+void bytecode_vm::set_global(int index, value global) {
+	if (_global_types[index] == expression_type::Double)
+		_registers[index].double_value = global.as_double();
+	else
+		_registers[index].long_value = global.as_long();
+}
+
+value bytecode_vm::get_global(int index) const {
+	if (_global_types[index] == expression_type::Double)
+		return value(_registers[index].double_value);
+
+	return value(_registers[index].long_value);
+}
+
+std::map<std::string, value> bytecode_vm::evaluate(const std::map<std::string, value>& inputs) {
+	for (size_t i = 0; i < _global_types.size(); i++)
+		set_global((int)i, value());
+
+	for (auto i = _program.input_variables.cbegin(); i != _program.input_variables.cend(); i++) {
+		auto input = inputs.find(i->first);
+		if (input == inputs.end())
+			throw new std::runtime_error("Value of input variable `" + i->first + "` is not set.");
+
+		set_global(_program.globals[i->first], input->second);
+	}
+
+	run();
+
+	std::map<std::string, value> outputs;
+	for (auto i = _program.output_variables.cbegin(); i != _program.output_variables.cend(); i++)
+		outputs[i->first] = get_global(_program.globals[i->first]);
+
+	return outputs;
+}
+
+void bytecode_vm::run() {
+	const bytecode_function* function = &_program.functions[0];
+	const instruction* code = function->code.data();
+	const slot* constants = _program.constants.data();
+	size_t pc = 0;
+	int base = 0;
+	slot* r = _registers.data();
+
+	_frames.clear();
+
+	for (;;) {
+		const instruction& i = code[pc++];
+
+		switch (i.opcode) {
+		case opcode::LoadConstant:
+			r[i.a] = constants[i.b];
+			break;
+		case opcode::LoadGlobal:
+			r[i.a] = _registers[i.b];
+			break;
+		case opcode::Move:
+			r[i.a] = r[i.b];
+			break;
+		case opcode::LongToDouble:
+			r[i.a].double_value = (double)r[i.b].long_value;
+			break;
+		case opcode::DoubleToLong:
+			r[i.a].long_value = (long)r[i.b].double_value;
+			break;
+
+		case opcode::AddLong:
+			r[i.a].long_value = r[i.b].long_value + r[i.c].long_value;
+			break;
+		case opcode::SubtractLong:
+			r[i.a].long_value = r[i.b].long_value - r[i.c].long_value;
+			break;
+		case opcode::MultiplyLong:
+			r[i.a].long_value = r[i.b].long_value * r[i.c].long_value;
+			break;
+		case opcode::DivideLong:
+			if (r[i.c].long_value == 0)
+				throw new std::runtime_error("Division by zero.");
+			r[i.a].long_value = r[i.b].long_value / r[i.c].long_value;
+			break;
+		case opcode::ReminderLong:
+			if (r[i.c].long_value == 0)
+				throw new std::runtime_error("Division by zero.");
+			r[i.a].long_value = r[i.b].long_value % r[i.c].long_value;
+			break;
+
+		case opcode::AddDouble:
+			r[i.a].double_value = r[i.b].double_value + r[i.c].double_value;
+			break;
+		case opcode::SubtractDouble:
+			r[i.a].double_value = r[i.b].double_value - r[i.c].double_value;
+			break;
+		case opcode::MultiplyDouble:
+			r[i.a].double_value = r[i.b].double_value * r[i.c].double_value;
+			break;
+		case opcode::DivideDouble:
+			r[i.a].double_value = r[i.b].double_value / r[i.c].double_value;
+			break;
+		case opcode::ReminderDouble:
+			r[i.a].double_value = std::fmod(r[i.b].double_value, r[i.c].double_value);
+			break;
+		case opcode::PowDouble:
+			r[i.a].double_value = std::pow(r[i.b].double_value, r[i.c].double_value);
+			break;
+
+		case opcode::NegativeLong:
+			r[i.a].long_value = -r[i.b].long_value;
+			break;
+		case opcode::NegativeDouble:
+			r[i.a].double_value = -r[i.b].double_value;
+			break;
+
+		case opcode::LessLong:
+			r[i.a].long_value = r[i.b].long_value < r[i.c].long_value;
+			break;
+		case opcode::LessEqualLong:
+			r[i.a].long_value = r[i.b].long_value <= r[i.c].long_value;
+			break;
+		case opcode::GreaterLong:
+			r[i.a].long_value = r[i.b].long_value > r[i.c].long_value;
+			break;
+		case opcode::GreaterEqualLong:
+			r[i.a].long_value = r[i.b].long_value >= r[i.c].long_value;
+			break;
+		case opcode::EqualLong:
+			r[i.a].long_value = r[i.b].long_value == r[i.c].long_value;
+			break;
+		case opcode::NotEqualLong:
+			r[i.a].long_value = r[i.b].long_value != r[i.c].long_value;
+			break;
+		case opcode::LessDouble:
+			r[i.a].long_value = r[i.b].double_value < r[i.c].double_value;
+			break;
+		case opcode::LessEqualDouble:
+			r[i.a].long_value = r[i.b].double_value <= r[i.c].double_value;
+			break;
+		case opcode::GreaterDouble:
+			r[i.a].long_value = r[i.b].double_value > r[i.c].double_value;
+			break;
+		case opcode::GreaterEqualDouble:
+			r[i.a].long_value = r[i.b].double_value >= r[i.c].double_value;
+			break;
+		case opcode::EqualDouble:
+			r[i.a].long_value = r[i.b].double_value == r[i.c].double_value;
+			break;
+		case opcode::NotEqualDouble:
+			r[i.a].long_value = r[i.b].double_value != r[i.c].double_value;
+			break;
+		case opcode::Not:
+			r[i.a].long_value = !r[i.b].long_value;
+			break;
+
+		case opcode::Jump:
+			pc = i.a;
+			break;
+		case opcode::JumpIfFalse:
+			if (!r[i.a].long_value)
+				pc = i.b;
+			break;
+		case opcode::JumpIfTrue:
+			if (r[i.a].long_value)
+				pc = i.b;
+			break;
+
+		case opcode::CallUnary:
+			r[i.a].double_value = _program.unary_functions[i.c](r[i.b].double_value);
+			break;
+		case opcode::CallBinary:
+			r[i.a].double_value = _program.binary_functions[i.c](r[i.b].double_value, r[i.b + 1].double_value);
+			break;
+
+		// Calls don't use the native stack, so the recursion depth is limited by memory only.
+		case opcode::Call: {
+			_frames.push_back(frame{ function, pc, base, i.a });
+
+			function = &_program.functions[i.c];
+			code = function->code.data();
+			pc = 0;
+			base += i.b;
+
+			if (_registers.size() < (size_t)(base + function->register_count))
+				_registers.resize(2 * (base + function->register_count));
+
+			r = _registers.data() + base;
+			break;
+		}
+		case opcode::Return: {
+			if (_frames.empty())
+				return;
+
+			slot result = r[i.a];
+			frame caller = _frames.back();
+			_frames.pop_back();
+
+			function = caller.function;
+			code = function->code.data();
+			pc = caller.return_address;
+			base = caller.base;
+			r = _registers.data() + base;
+			r[caller.result_register] = result;
+			break;
+		}
+		}
+	}
+}
@@ -0,0 +1,42 @@
+#ifndef __BYTECODE_VM_H__
+#define __BYTECODE_VM_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bytecode.h"
+
+class bytecode_vm
+{
+public:
+	bytecode_vm(const bytecode_program& program);
+
+	void set_global(int index, value global);
+
+	value get_global(int index) const;
+
+	// Executes the main chunk over the current values of globals.
+	void run();
+
+	// Sets all the globals from inputs, executes the assignments and returns the values of output variables.
+	std::map<std::string, value> evaluate(const std::map<std::string, value>& inputs);
+
+	const std::map<std::string, expression_type>& input_variables() const { return _program.input_variables; }
+
+private:
+	struct frame
+	{
+		const bytecode_function* function;
+		size_t return_address;
+		int base;
+		int result_register;
+	};
+
+	bytecode_program _program;
+	std::vector<expression_type> _global_types;
+	std::vector<slot> _registers;
+	std::vector<frame> _frames;
+};
+
+#endif
@@ -1,12 +1,25 @@
+#include <algorithm>
 #include <exception>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "compiler_statistics.h"
+#include "evaluator.h"
 #include "parser.h"
 #include "printer.h"
 #include "generator.h"
+#include "large_stack.h"
+#include "scanner.h"
+#include "thread_pool.h"
 
 #if defined WIN32 || defined _WIN32 || defined __CYGWIN__
 #define PATH_SEPARATOR '\\'
@@ -14,61 +27,261 @@
 #define PATH_SEPARATOR '/'
 #endif
 
-void compile(const std::string& infile, const std::string& outfile);
-void compile(const ast_program* program, const std::string& outfile);
+void compile(const std::string& infile, const std::string& outfile, const generator_options& options,
+	compiler_statistics* statistics = nullptr);
+void compile(const ast_program* program, const std::string& outfile, const generator_options& options,
+	compiler_statistics* statistics = nullptr);
+int compile_files(const std::vector<std::string>& infiles, size_t jobs, const generator_options& options);
+std::vector<std::string> expand_response_files(const std::vector<std::string>& arguments);
+std::string canonical_path(const std::string& name);
+const ast_program* parse(const std::string& infile);
+const ast_program* parse_measured(const std::string& infile, compiler_statistics& statistics);
+void evaluate(const std::string& infile, const std::map<std::string, std::string>& arguments,
+	const evaluation_options& options);
 std::string replace_extension(const std::string& filename, const std::string& extension);
+std::vector<std::string> split_names(const std::string& names);
 
 int main(int argc, const char* const* argv) {
-    std::cout << "COMpiling CALCulator" << std::endl;
+    std::string outfile;
+    generator_options options;
+    bool is_evaluation = false;
+    evaluation_options evaluation;
+    std::map<std::string, std::string> arguments;
+    bool is_usage_valid = argc >= 2;
+    // Many inputs compiled at once, each into its own .ll file.
+    bool is_multiple = argc >= 2 && (argv[1][0] == '@' || std::string(argv[1]).compare(0, 7, "--jobs=") == 0);
+    std::vector<std::string> infiles;
+    size_t jobs = std::max(std::thread::hardware_concurrency(), 1u);
+    bool is_time_passes = false;
+    bool is_stats = false;
+    bool is_json = false;
 
-    if(argc < 2 || argc > 3) {
-        std::cerr << "  Usage: comcalc in.cc [out.ll]    -- generate LLVM IR" << std::endl;
-        std::cerr << "         comcalc in.cc --ast       -- print AST" << std::endl;
+    for (int i = is_multiple ? 1 : 2; i < argc && is_usage_valid; i++) {
+        std::string argument = argv[i];
+
+        if (argument == "--memoize")
+            evaluation.memoize = true;
+        else if (argument.compare(0, 10, "--threads=") == 0 && argument.length() > 10 && argument.length() <= 13
+            && argument.find_first_not_of("0123456789", 10) == std::string::npos)
+            evaluation.threads = std::stoi(argument.substr(10));
+        else if (is_multiple && argument.compare(0, 7, "--jobs=") == 0 && argument.length() > 7 && argument.length() <= 10
+            && argument.find_first_not_of("0123456789", 7) == std::string::npos)
+            jobs = std::stoi(argument.substr(7));
+        else if (argument == "--specialize" && i + 1 < argc) {
+            std::string input = argv[++i];
+            size_t equal_position = input.find('=');
+
+            if (equal_position == std::string::npos || equal_position == 0)
+                is_usage_valid = false;
+            else
+                options.specialized_inputs[input.substr(0, equal_position)] = input.substr(equal_position + 1);
+        }
+        else if (argument == "--cache" && i + 1 < argc && options.cache_path.empty())
+            options.cache_path = argv[++i];
+        else if (argument == "--incremental")
+            evaluation.incremental = true;
+        else if (argument == "--outputs" && i + 1 < argc && options.outputs.empty()) {
+            options.outputs = split_names(argv[++i]);
+            evaluation.outputs = options.outputs;
+            is_usage_valid = !options.outputs.empty();
+        }
+        else if (is_evaluation) {
+            size_t equal_position = argument.find('=');
+
+            if (equal_position == std::string::npos || equal_position == 0)
+                is_usage_valid = false;
+            else
+                arguments[argument.substr(0, equal_position)] = argument.substr(equal_position + 1);
+        }
+        else if (argument == "--eval" && outfile.empty())
+            is_evaluation = true;
+        else if (argument == "--vm" && outfile.empty()) {
+            is_evaluation = true;
+            evaluation.engine = evaluation_engine::Bytecode;
+        }
+        else if ((argument == "--jit" || argument == "--jit-perf") && outfile.empty()) {
+            is_evaluation = true;
+            evaluation.engine = evaluation_engine::Jit;
+            evaluation.perf_map = argument == "--jit-perf";
+        }
+        else if ((argument == "--time-passes" || argument == "--time-passes=json") && !is_time_passes) {
+            is_time_passes = true;
+            is_json = is_json || argument == "--time-passes=json";
+        }
+        else if ((argument == "--stats" || argument == "--stats=json") && !is_stats) {
+            is_stats = true;
+            is_json = is_json || argument == "--stats=json";
+        }
+        else if (argument == "--batch")
+            options.batch = true;
+        else if (argument == "--vector=4" || argument == "--vector=8")
+            options.vector_width = std::stoi(argument.substr(9));
+        else if (is_multiple && argument.compare(0, 2, "--") != 0)
+            infiles.push_back(argument);
+        else if (outfile.empty())
+            outfile = argument;
+        else
+            is_usage_valid = false;
+    }
+
+    if (evaluation.memoize && evaluation.engine != evaluation_engine::Jit)
+        is_usage_valid = false;
+
+    if (is_evaluation && (!options.specialized_inputs.empty() || !options.cache_path.empty()))
+        is_usage_valid = false;
+
+    if (evaluation.incremental && (!is_evaluation || evaluation.engine != evaluation_engine::TreeWalk))
+        is_usage_valid = false;
+
+    if (evaluation.threads < 1 || (evaluation.threads > 1 && (!is_evaluation || evaluation.engine != evaluation_engine::TreeWalk)))
+        is_usage_valid = false;
+
+    if (is_multiple && (infiles.empty() || jobs < 1 || is_evaluation || !outfile.empty() || !options.cache_path.empty()))
+        is_usage_valid = false;
+
+    if ((is_time_passes || is_stats) && (is_evaluation || is_multiple || outfile == "--ast"))
+        is_usage_valid = false;
+
+    if(!is_usage_valid) {
+        std::cerr << "  Usage: comcalc in.cc [out.ll]            -- generate LLVM IR" << std::endl;
+        std::cerr << "         comcalc in.cc [out.ll] --batch    -- generate LLVM IR which reads rows of inputs until EOF" << std::endl;
+        std::cerr << "         comcalc in.cc [out.ll] --vector=4 -- generate kernel over column arrays, 4 or 8 rows at once" << std::endl;
+        std::cerr << "         comcalc in.cc [out.ll] --outputs x1,x2 -- generate only what outputs x1 and x2 need" << std::endl;
+        std::cerr << "         comcalc in.cc [out.ll] --specialize a=1 -- generate LLVM IR for the known value of input a" << std::endl;
+        std::cerr << "         comcalc in.cc [out.ll] --cache file -- reuse code of unchanged assignments stored in file" << std::endl;
+        std::cerr << "         comcalc in.cc [out.ll] --time-passes -- print time of every pass to stderr, =json for JSON" << std::endl;
+        std::cerr << "         comcalc in.cc [out.ll] --stats    -- print sizes and allocations of every pass to stderr, =json for JSON" << std::endl;
+        std::cerr << "         comcalc --jobs=8 a.cc b.cc @list  -- generate a.ll, b.ll and .ll of files listed in list on 8 threads" << std::endl;
+        std::cerr << "         comcalc in.cc --ast               -- print AST" << std::endl;
+        std::cerr << "         comcalc in.cc --eval a=1 b=2      -- evaluate without compilation" << std::endl;
+        std::cerr << "         comcalc in.cc --eval --threads=4 a=1 -- same, independent assignments run at once" << std::endl;
+        std::cerr << "         comcalc in.cc --eval --incremental a=1 -- same, then recompute on `name=value` lines from stdin" << std::endl;
+        std::cerr << "         comcalc in.cc --vm a=1 b=2        -- evaluate with bytecode virtual machine" << std::endl;
+        std::cerr << "         comcalc in.cc --jit a=1 b=2       -- evaluate with in-process JIT compiler" << std::endl;
+        std::cerr << "         comcalc in.cc --jit-perf a=1 b=2  -- same, and register code in /tmp/perf-<pid>.map" << std::endl;
+        std::cerr << "         comcalc in.cc --jit --memoize n=1 -- same, and cache results of pure recursive functions" << std::endl;
 
         return 2;
     }
 
     try {
+        if (is_multiple) {
+            std::cout << "COMpiling CALCulator" << std::endl;
+
+            return compile_files(expand_response_files(infiles), jobs, options);
+        }
+
         std::string infile = argv[1];
-        std::string outfile = argc == 3 ? std::string(argv[2]) : replace_extension(infile, ".ll");
+
+        if (is_evaluation) {
+            evaluate(infile, arguments, evaluation);
+
+            return 0;
+        }
+
+        std::cout << "COMpiling CALCulator" << std::endl;
+
+        if (outfile.empty())
+            outfile = replace_extension(infile, ".ll");
         
-        compile(infile, outfile);
+        std::unique_ptr<compiler_statistics> statistics;
+        if (is_time_passes || is_stats)
+            statistics.reset(new compiler_statistics());
+
+        compile(infile, outfile, options, statistics.get());
+
+        if (statistics && is_json)
+            statistics->print_json(std::cerr, is_time_passes, is_stats);
+        else if (statistics)
+            statistics->print(std::cerr, is_time_passes, is_stats);
     }
     catch(std::exception &exception) {
         std::cerr << exception.what() << std::endl;
 
         return 1;
     }
+    catch(std::exception* exception) {
+        std::cerr << exception->what() << std::endl;
+        delete exception;
+
+        return 1;
+    }
 
     return 0;
 }
 
-void compile(const std::string& infile, const std::string& outfile) {
-	std::ifstream in;
-	in.open(infile);
+// The passes after parsing recurse over expressions, so deep programs run on a thread with
+// a stack for their depth. Their assignments are not spread over threads with default stacks.
+void compile(const std::string& infile, const std::string& outfile, const generator_options& options,
+	compiler_statistics* statistics) {
+	const ast_program* program = statistics != nullptr ? parse_measured(infile, *statistics) : parse(infile);
 
 	try {
-		parser parser(in);
-		const ast_program* program = parser.parse_program();
+		run_with_stack_for_depth(expression_depth(program), [&]() {
+			if (statistics != nullptr)
+				statistics->count_nodes(program);
 
-		if (outfile == "--ast")
-			print(program, std::cout);
-		else
-			compile(program, outfile);
+			if (outfile == "--ast")
+				print(program, std::cout);
+			else
+				compile(program, outfile, options, statistics);
+		});
 	}
-	catch (std::exception&) {
-		in.close();
+	catch (...) {
+		delete program;
 
 		throw;
 	}
+
+	delete program;
+}
+
+void evaluate(const std::string& infile, const std::map<std::string, std::string>& arguments,
+	const evaluation_options& options) {
+	const ast_program* program = parse(infile);
+
+	try {
+		size_t depth = expression_depth(program);
+		evaluation_options program_options = options;
+		if (depth > shallow_expression_depth)
+			program_options.threads = 1;
+
+		run_with_stack_for_depth(depth, [&]() {
+			if (program_options.incremental)
+				evaluate_incrementally(program, arguments, std::cin, std::cout, program_options);
+			else
+				evaluate(program, arguments, std::cout, program_options);
+		});
+	}
+	catch (...) {
+		delete program;
+
+		throw;
+	}
+
+	delete program;
+}
+
+const ast_program* parse(const std::string& infile) {
+	std::ifstream in;
+	in.open(infile);
+	if (!in.is_open())
+		throw new std::runtime_error("Can't read input file `" + infile + "`.");
+
+	parser parser(in);
+
+	return parser.parse_program();
 }
 
-void compile(const ast_program* program, const std::string& outfile) {
+void compile(const ast_program* program, const std::string& outfile, const generator_options& options,
+	compiler_statistics* statistics) {
 	std::ofstream out;
 	out.open(outfile);
+	if (!out.is_open())
+		throw new std::runtime_error("Can't write output file `" + outfile + "`.");
 
 	try {
-		generate(program, out);
+		generate(program, out, options, statistics);
 	}
 	catch (std::exception&) {
 		out.close();
@@ -77,6 +290,128 @@ void compile(const ast_program* program, const std::string& outfile) {
 	}
 }
 
+// Reads, scans and parses as separate passes. The parser scans again, so the "parse"
+// pass includes its own scanning and "scan" shows what scanning alone costs.
+const ast_program* parse_measured(const std::string& infile, compiler_statistics& statistics) {
+	std::string text;
+	{
+		pass_timer timer(&statistics, "read");
+		std::ifstream in(infile, std::ios::binary);
+		if (!in.is_open())
+			throw new std::runtime_error("Can't read input file `" + infile + "`.");
+
+		std::ostringstream buffer;
+		buffer << in.rdbuf();
+		text = buffer.str();
+	}
+
+	{
+		pass_timer timer(&statistics, "scan");
+		scanner scanner(text);
+		size_t lexemes = 0;
+
+		for (; scanner.lexeme() != lexeme::Eof; scanner.next())
+			lexemes++;
+
+		statistics.set_counter("lexemes", lexemes);
+	}
+
+	pass_timer parse_timer(&statistics, "parse");
+	parser parser(text);
+	const ast_program* program = parser.parse_program();
+	parse_timer.stop();
+
+	return program;
+}
+
+// Diagnostics are printed after all the files are done, in the order of the files.
+// A file whose .ll file is already written for a previous file (`a.cc` and `a.comcalc`)
+// is not compiled, so no two threads write the same file.
+int compile_files(const std::vector<std::string>& infiles, size_t jobs, const generator_options& options) {
+	std::vector<std::string> errors(infiles.size());
+	std::map<std::string, size_t> outfile_writers;
+
+	for (size_t i = 0; i < infiles.size(); i++) {
+		auto outfile = replace_extension(infiles[i], ".ll");
+		auto writer = outfile_writers.emplace(canonical_path(outfile), i);
+
+		if (!writer.second)
+			errors[i] = "Output file `" + outfile + "` is written for `" + infiles[writer.first->second] + "` already.";
+	}
+
+	thread_pool pool(std::min(jobs, infiles.size()));
+
+	pool.run(infiles.size(), [&](size_t, size_t index) {
+		if (!errors[index].empty())
+			return;
+
+		try {
+			compile(infiles[index], replace_extension(infiles[index], ".ll"), options);
+		}
+		catch (std::exception& exception) {
+			errors[index] = exception.what();
+		}
+		catch (std::exception* exception) {
+			errors[index] = exception->what();
+			delete exception;
+		}
+	});
+
+	int result = 0;
+	for (size_t i = 0; i < infiles.size(); i++) {
+		if (errors[i].empty())
+			continue;
+
+		std::cerr << infiles[i] << ": " << errors[i] << std::endl;
+		result = 1;
+	}
+
+	return result;
+}
+
+// Replaces every `@file` with the names listed in the file, one per line. A file named
+// more than once is kept at its first place only, so no two threads write its .ll file.
+std::vector<std::string> expand_response_files(const std::vector<std::string>& arguments) {
+	std::vector<std::string> names;
+
+	for (auto i = arguments.cbegin(); i != arguments.cend(); i++) {
+		if ((*i)[0] != '@') {
+			names.push_back(*i);
+			continue;
+		}
+
+		std::ifstream in(i->substr(1));
+		if (!in)
+			throw new std::runtime_error("Can't read response file `" + i->substr(1) + "`.");
+
+		std::string line;
+		while (std::getline(in, line)) {
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+
+			if (!line.empty())
+				names.push_back(line);
+		}
+	}
+
+	std::vector<std::string> result;
+	std::set<std::string> unique_paths;
+
+	for (auto i = names.cbegin(); i != names.cend(); i++) {
+		if (unique_paths.insert(canonical_path(*i)).second)
+			result.push_back(*i);
+	}
+
+	return result;
+}
+
+// The same path for every name of an existing or a new file, the name itself if it can't be resolved.
+std::string canonical_path(const std::string& name) {
+	std::error_code error;
+	auto path = std::filesystem::weakly_canonical(name, error);
+
+	return error ? name : path.string();
+}
 
 std::string replace_extension(const std::string& filename, const std::string& extension) {
 	size_t separator_position = filename.rfind(PATH_SEPARATOR);
@@ -94,3 +429,21 @@ std::string replace_extension(const std::string& filename, const std::string& ex
 	return filename.substr(0, point_position) + extension;
 }
 
+std::vector<std::string> split_names(const std::string& names) {
+	std::vector<std::string> result;
+	size_t start = 0;
+
+	while (start <= names.length()) {
+		size_t comma_position = names.find(',', start);
+		if (comma_position == std::string::npos)
+			comma_position = names.length();
+
+		if (comma_position == start)
+			return std::vector<std::string>();
+
+		result.push_back(names.substr(start, comma_position - start));
+		start = comma_position + 1;
+	}
+
+	return result;
+}
@@ -0,0 +1,250 @@
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include "compilation_cache.h"
+
+// Changes whenever the generated code or the file format changes, so old files are ignored.
+static const char* const cache_header = "comcalc-cache 2";
+
+compilation_cache::compilation_cache(const std::string& path) : _path(path), _used_count(0), _is_changed(false) {
+	std::ifstream in(path, std::ios::binary);
+	std::string header;
+
+	if (!std::getline(in, header) || header != cache_header)
+		return;
+
+	std::string line;
+	while (std::getline(in, line)) {
+		std::istringstream fields(line);
+		size_t key_length;
+		size_t declaration_count;
+		size_t code_length;
+		cached_fragment fragment;
+
+		if (!(fields >> key_length >> fragment.register_count >> declaration_count >> code_length))
+			break;
+
+		std::string key(key_length, '\0');
+		if (!in.read(&key[0], key_length))
+			break;
+
+		for (size_t i = 0; i < declaration_count && std::getline(in, line); i++)
+			fragment.declarations.insert(line);
+
+		fragment.code.resize(code_length);
+		if (!in.read(&fragment.code[0], code_length))
+			break;
+
+		_fragments[key] = entry{ fragment, false };
+	}
+}
+
+const cached_fragment* compilation_cache::find(const std::string& key) {
+	auto fragment = _fragments.find(key);
+	if (fragment == _fragments.end())
+		return nullptr;
+
+	if (!fragment->second.is_used) {
+		fragment->second.is_used = true;
+		_used_count++;
+	}
+
+	return &fragment->second.fragment;
+}
+
+void compilation_cache::store(const std::string& key, const cached_fragment& fragment) {
+	auto& stored = _fragments[key];
+	if (!stored.is_used)
+		_used_count++;
+
+	stored = entry{ fragment, true };
+	_is_changed = true;
+}
+
+void compilation_cache::save() const {
+	if (!_is_changed && _used_count == _fragments.size())
+		return;
+
+	// Concurrent runs write temporary files of their own, the last one renamed wins.
+	auto temporary_path = _path + "." + std::to_string(std::random_device()()
+		^ (unsigned)std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+
+	std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+	if (!out)
+		throw new std::runtime_error("Can't write compilation cache `" + _path + "`.");
+
+	out << cache_header << "\n";
+	for (auto i = _fragments.cbegin(); i != _fragments.cend(); i++) {
+		if (!i->second.is_used)
+			continue;
+
+		auto& fragment = i->second.fragment;
+
+		out << i->first.length() << " " << fragment.register_count << " "
+			<< fragment.declarations.size() << " " << fragment.code.length() << "\n";
+		out << i->first;
+
+		for (auto j = fragment.declarations.cbegin(); j != fragment.declarations.cend(); j++)
+			out << *j << "\n";
+
+		out << fragment.code;
+	}
+
+	out.close();
+
+	std::error_code error;
+	if (out)
+		std::filesystem::rename(temporary_path, _path, error);
+
+	if (!out || error) {
+		std::filesystem::remove(temporary_path, error);
+
+		throw new std::runtime_error("Can't write compilation cache `" + _path + "`.");
+	}
+}
+
+// Prefix notation of the definition.
+class definition_key : private visitor
+{
+private:
+	const symbol_table& _symbols;
+	const std::vector<expression_type>& _variable_types;
+	std::string _key;
+
+	void add(const void* data, size_t size) {
+		_key.append((const char*)data, size);
+	}
+
+	void add(const std::string& text) {
+		add(text.c_str(), text.length() + 1);
+	}
+
+	void add(char tag, int number) {
+		add(&tag, sizeof(tag));
+		add(&number, sizeof(number));
+	}
+
+	void add_variable(symbol_id symbol) {
+		add(_symbols.name(symbol));
+		add('t', (int)_variable_types[symbol]);
+	}
+
+	virtual void visit_assignment(const ast_assignment* assignment) {
+		add('=', 0);
+		add_variable(assignment->symbol());
+
+		visitor::visit_assignment(assignment);
+	}
+
+	virtual void visit_long(const ast_long* _long) {
+		long value = _long->value();
+
+		add('l', 0);
+		add(&value, sizeof(value));
+	}
+
+	virtual void visit_double(const ast_double* _double) {
+		double value = _double->value();
+
+		add('d', 0);
+		add(&value, sizeof(value));
+	}
+
+	virtual void visit_variable(const ast_variable* variable) {
+		add('v', (int)variable->type());
+		add_variable(variable->symbol());
+	}
+
+	virtual void visit_call(const ast_call* call) {
+		add('c', (int)call->type());
+		add(call->name());
+		add('n', (int)call->parameters().size());
+
+		visitor::visit_call(call);
+	}
+
+	virtual void visit_unary_operator(const ast_unary_operator* unary_operator) {
+		add('u', (int)unary_operator->operation());
+
+		visitor::visit_unary_operator(unary_operator);
+	}
+
+	virtual void visit_binary_operator(const ast_binary_operator* binary_operator) {
+		add('b', (int)binary_operator->operation());
+		add('t', (int)binary_operator->type());
+
+		visitor::visit_binary_operator(binary_operator);
+	}
+
+	virtual void visit_logical_binary_operator(const ast_logical_binary_operator* logical_binary_operator) {
+		add('L', 0);
+		add(logical_binary_operator->operation());
+
+		visitor::visit_logical_binary_operator(logical_binary_operator);
+	}
+
+	virtual void visit_logical_not_operator(const ast_logical_not_operator* logical_not_operator) {
+		add('!', 0);
+
+		visitor::visit_logical_not_operator(logical_not_operator);
+	}
+
+	virtual void visit_condition(const ast_condition* condition) {
+		add('C', 0);
+		add(condition->operation());
+
+		visitor::visit_condition(condition);
+	}
+
+	virtual void visit_if_then_else(const ast_if_then_else* if_then_else) {
+		add('?', (int)if_then_else->type());
+
+		visitor::visit_if_then_else(if_then_else);
+	}
+
+public:
+	definition_key(const symbol_table& symbols, const std::vector<expression_type>& variable_types)
+		: _symbols(symbols), _variable_types(variable_types) { }
+
+	std::string key(const ast_assignment* assignment, const std::string& context) {
+		add(context);
+		assignment->accept(*this);
+
+		return _key;
+	}
+};
+
+std::string assignment_key(const ast_assignment* assignment, const symbol_table& symbols,
+	const std::vector<expression_type>& variable_types, const std::string& context) {
+	definition_key key(symbols, variable_types);
+
+	return key.key(assignment, context);
+}
+
+std::string renumber_registers(const std::string& code, int base) {
+	std::string result;
+	result.reserve(code.length() + code.length() / 8);
+
+	size_t i = 0;
+	while (i < code.length()) {
+		char c = code[i++];
+		result += c;
+
+		if (c != '%' || i == code.length() || !std::isdigit((unsigned char)code[i]))
+			continue;
+
+		int number = 0;
+		while (i < code.length() && std::isdigit((unsigned char)code[i]))
+			number = number * 10 + (code[i++] - '0');
+
+		result += std::to_string(base + number);
+	}
+
+	return result;
+}
@@ -0,0 +1,66 @@
+#ifndef __COMPILATION_CACHE_H__
+#define __COMPILATION_CACHE_H__
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+#include "symbol_table.h"
+
+// IR of one assignment generated with its own register numbering from %0, so it can be
+// spliced at any place of a function after renumbering.
+struct cached_fragment
+{
+	int register_count;
+	// Declarations the code needs besides the ones of standard functions.
+	std::set<std::string> declarations;
+	std::string code;
+};
+
+// Content-addressed store of fragments in one file. Keys are whole canonical texts of
+// definitions, not hashes of them, so a fragment is found only for the same definition.
+// An edited definition gets a new key, and unchanged ones are found again.
+class compilation_cache
+{
+public:
+	// Loads the fragments stored in the file. A missing or foreign file is an empty cache.
+	compilation_cache(const std::string& path);
+
+	// Returns nullptr if there is no fragment with the key. The fragment found is kept
+	// by save().
+	const cached_fragment* find(const std::string& key);
+
+	void store(const std::string& key, const cached_fragment& fragment);
+
+	// Writes only the fragments found or stored since loading, so fragments of edited
+	// definitions don't pile up. The file is not written if it would stay the same.
+	// A temporary file replaces the cache, so a crash or a concurrent run never leaves
+	// a partly written cache behind.
+	void save() const;
+
+private:
+	struct entry
+	{
+		cached_fragment fragment;
+		bool is_used;
+	};
+
+	std::string _path;
+	std::unordered_map<std::string, entry> _fragments;
+	size_t _used_count;
+	bool _is_changed;
+};
+
+// Canonical text of the assignment in prefix notation: operators, literals and names of
+// its expression, types of the variables it reads and writes taken from `variable_types`
+// (indexed by symbol ids), and `context`, which distinguishes code generated for
+// different modes. The text is binary, literals are stored as their bytes.
+std::string assignment_key(const ast_assignment* assignment, const symbol_table& symbols,
+	const std::vector<expression_type>& variable_types, const std::string& context);
+
+// Shifts numbers of all the registers `%N` in the code by `base`.
+std::string renumber_registers(const std::string& code, int base);
+
+#endif
@@ -0,0 +1,242 @@
+#include <cstdint>
+#include <iomanip>
+
+#if defined WIN32 || defined _WIN32 || defined __CYGWIN__
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+#include "compiler_statistics.h"
+
+std::atomic<size_t> allocation_count(0);
+
+// CPU time of the whole process, user and kernel.
+static double cpu_seconds() {
+#if defined WIN32 || defined _WIN32 || defined __CYGWIN__
+	FILETIME creation, exit, kernel, user;
+	GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+
+	auto ticks = [](FILETIME time) { return ((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime; };
+
+	return (ticks(kernel) + ticks(user)) * 1e-7;
+#else
+	timespec time;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+
+	return time.tv_sec + time.tv_nsec * 1e-9;
+#endif
+}
+
+static size_t peak_rss_bytes() {
+#if defined WIN32 || defined _WIN32 || defined __CYGWIN__
+	PROCESS_MEMORY_COUNTERS counters;
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	// Linux reports kilobytes.
+	return (size_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+pass_timer::pass_timer(compiler_statistics* statistics, const std::string& pass)
+	: _statistics(statistics), _pass(pass), _cpu_start(0.0), _allocations_start(0), _peak_rss_start(0) {
+	if (_statistics == nullptr)
+		return;
+
+	_allocations_start = allocation_count.load(std::memory_order_relaxed);
+	_peak_rss_start = peak_rss_bytes();
+	_cpu_start = cpu_seconds();
+	_wall_start = std::chrono::steady_clock::now();
+}
+
+pass_timer::~pass_timer() {
+	stop();
+}
+
+void pass_timer::stop() {
+	if (_statistics == nullptr)
+		return;
+
+	auto wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _wall_start).count();
+	auto cpu = cpu_seconds() - _cpu_start;
+
+	auto allocations = allocation_count.load(std::memory_order_relaxed) - _allocations_start;
+
+	_statistics->add_pass(pass_statistics{ _pass, wall_seconds, cpu, allocations, peak_rss_bytes() - _peak_rss_start });
+	_statistics = nullptr;
+}
+
+class node_counter : private visitor
+{
+private:
+	size_t _functions = 0;
+	size_t _assignments = 0;
+	size_t _longs = 0;
+	size_t _doubles = 0;
+	size_t _variables = 0;
+	size_t _calls = 0;
+	size_t _unary_operators = 0;
+	size_t _binary_operators = 0;
+	size_t _logical_binary_operators = 0;
+	size_t _logical_not_operators = 0;
+	size_t _conditions = 0;
+	size_t _if_then_elses = 0;
+
+	virtual void visit_function(const ast_function* function) {
+		_functions++;
+		visitor::visit_function(function);
+	}
+
+	virtual void visit_assignment(const ast_assignment* assignment) {
+		_assignments++;
+		visitor::visit_assignment(assignment);
+	}
+
+	virtual void visit_long(const ast_long*) {
+		_longs++;
+	}
+
+	virtual void visit_double(const ast_double*) {
+		_doubles++;
+	}
+
+	virtual void visit_variable(const ast_variable*) {
+		_variables++;
+	}
+
+	virtual void visit_call(const ast_call* call) {
+		_calls++;
+		visitor::visit_call(call);
+	}
+
+	virtual void visit_unary_operator(const ast_unary_operator* unary_operator) {
+		_unary_operators++;
+		visitor::visit_unary_operator(unary_operator);
+	}
+
+	virtual void visit_binary_operator(const ast_binary_operator* binary_operator) {
+		_binary_operators++;
+		visitor::visit_binary_operator(binary_operator);
+	}
+
+	virtual void visit_logical_binary_operator(const ast_logical_binary_operator* logical_binary_operator) {
+		_logical_binary_operators++;
+		visitor::visit_logical_binary_operator(logical_binary_operator);
+	}
+
+	virtual void visit_logical_not_operator(const ast_logical_not_operator* logical_not_operator) {
+		_logical_not_operators++;
+		visitor::visit_logical_not_operator(logical_not_operator);
+	}
+
+	virtual void visit_condition(const ast_condition* condition) {
+		_conditions++;
+		visitor::visit_condition(condition);
+	}
+
+	virtual void visit_if_then_else(const ast_if_then_else* if_then_else) {
+		_if_then_elses++;
+		visitor::visit_if_then_else(if_then_else);
+	}
+
+public:
+	void count(const ast_program* program, compiler_statistics& statistics) {
+		program->accept(*this);
+
+		statistics.set_counter("ast_functions", _functions);
+		statistics.set_counter("ast_assignments", _assignments);
+		statistics.set_counter("ast_long_constants", _longs);
+		statistics.set_counter("ast_double_constants", _doubles);
+		statistics.set_counter("ast_variables", _variables);
+		statistics.set_counter("ast_calls", _calls);
+		statistics.set_counter("ast_unary_operators", _unary_operators);
+		statistics.set_counter("ast_binary_operators", _binary_operators);
+		statistics.set_counter("ast_logical_binary_operators", _logical_binary_operators);
+		statistics.set_counter("ast_logical_not_operators", _logical_not_operators);
+		statistics.set_counter("ast_conditions", _conditions);
+		statistics.set_counter("ast_if_then_elses", _if_then_elses);
+	}
+};
+
+void compiler_statistics::add_pass(const pass_statistics& pass) {
+	_passes.push_back(pass);
+}
+
+void compiler_statistics::set_counter(const std::string& name, size_t value) {
+	for (auto i = _counters.begin(); i != _counters.end(); i++) {
+		if (i->first == name) {
+			i->second = value;
+
+			return;
+		}
+	}
+
+	_counters.push_back(std::make_pair(name, value));
+}
+
+void compiler_statistics::count_nodes(const ast_program* program) {
+	node_counter counter;
+	counter.count(program, *this);
+
+	set_counter("identifiers", program->symbols().size());
+	set_counter("arena_bytes", program->arena().allocated_bytes());
+}
+
+void compiler_statistics::print(std::ostream& out, bool times, bool sizes) const {
+	out << std::left << std::setw(16) << "pass";
+	if (times)
+		out << std::right << std::setw(12) << "wall ms" << std::setw(12) << "cpu ms";
+	if (sizes)
+		out << std::right << std::setw(14) << "allocations" << std::setw(18) << "peak RSS +KB";
+	out << std::endl;
+
+	for (auto i = _passes.cbegin(); i != _passes.cend(); i++) {
+		out << std::left << std::setw(16) << i->name << std::right << std::fixed << std::setprecision(3);
+		if (times)
+			out << std::setw(12) << 1000.0 * i->wall_seconds << std::setw(12) << 1000.0 * i->cpu_seconds;
+		if (sizes)
+			out << std::setw(14) << i->allocations << std::setw(18) << i->peak_rss_growth_bytes / 1024;
+		out << std::endl;
+	}
+
+	if (!sizes)
+		return;
+
+	out << std::endl;
+	for (auto i = _counters.cbegin(); i != _counters.cend(); i++)
+		out << std::left << std::setw(30) << i->first << std::right << std::setw(14) << i->second << std::endl;
+}
+
+// Names of passes and counters are identifiers, so they need no escaping.
+void compiler_statistics::print_json(std::ostream& out, bool times, bool sizes) const {
+	out << "{" << std::endl << "  \"passes\": [";
+
+	for (auto i = _passes.cbegin(); i != _passes.cend(); i++) {
+		out << (i == _passes.cbegin() ? "" : ",") << std::endl << "    { \"name\": \"" << i->name << "\"";
+		if (times)
+			out << ", \"wall_seconds\": " << std::setprecision(9) << i->wall_seconds << ", \"cpu_seconds\": " << i->cpu_seconds;
+		if (sizes)
+			out << ", \"allocations\": " << i->allocations << ", \"peak_rss_growth_bytes\": " << i->peak_rss_growth_bytes;
+		out << " }";
+	}
+
+	out << std::endl << "  ]";
+
+	if (sizes) {
+		out << "," << std::endl << "  \"counters\": {";
+		for (auto i = _counters.cbegin(); i != _counters.cend(); i++)
+			out << (i == _counters.cbegin() ? "" : ",") << std::endl << "    \"" << i->first << "\": " << i->second;
+		out << std::endl << "  }";
+	}
+
+	out << std::endl << "}" << std::endl;
+}
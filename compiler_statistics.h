@@ -0,0 +1,76 @@
+#ifndef __COMPILER_STATISTICS_H__
+#define __COMPILER_STATISTICS_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ast.h"
+
+// Measurements of one pass of the compiler.
+struct pass_statistics
+{
+	std::string name;
+	double wall_seconds;
+	double cpu_seconds;
+	// Calls of `operator new` made by all the threads while the pass ran.
+	size_t allocations;
+	// Growth of the peak resident memory of the process during the pass.
+	size_t peak_rss_growth_bytes;
+};
+
+// Calls of `operator new`. Only executables linking allocation_counter.cpp, which replaces
+// the operator, count them. The others report no allocations.
+extern std::atomic<size_t> allocation_count;
+
+// Passes and counters of one compilation, reported by --time-passes and --stats.
+class compiler_statistics
+{
+public:
+	void add_pass(const pass_statistics& pass);
+
+	// Counters are reported in the order they are first set.
+	void set_counter(const std::string& name, size_t value);
+
+	// Sets counters of AST nodes by kind, of identifiers and of arena bytes.
+	void count_nodes(const ast_program* program);
+
+	// `times` selects wall and CPU time of passes, `sizes` selects allocations,
+	// memory and counters.
+	void print(std::ostream& out, bool times, bool sizes) const;
+
+	void print_json(std::ostream& out, bool times, bool sizes) const;
+
+private:
+	std::vector<pass_statistics> _passes;
+	std::vector<std::pair<std::string, size_t>> _counters;
+};
+
+// Measures a pass from construction to stop() or destruction. Does nothing without statistics.
+class pass_timer
+{
+public:
+	pass_timer(compiler_statistics* statistics, const std::string& pass);
+
+	~pass_timer();
+
+	void stop();
+
+	pass_timer(const pass_timer&) = delete;
+
+	pass_timer& operator=(const pass_timer&) = delete;
+
+private:
+	compiler_statistics* _statistics;
+	std::string _pass;
+	std::chrono::steady_clock::time_point _wall_start;
+	double _cpu_start;
+	size_t _allocations_start;
+	size_t _peak_rss_start;
+};
+
+#endif
@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+
+#include "constant_folder.h"
+
+// Collects variables and standard functions the folded program still uses. Reads of
+// parameters of a function are not reads of the variables of the same names.
+class folded_uses : private visitor
+{
+private:
+	std::vector<bool> _is_read;
+	std::set<std::string> _standard_functions;
+	const std::vector<symbol_id>* _parameters = nullptr;
+
+	virtual void visit_variable(const ast_variable* variable) {
+		if (_parameters == nullptr || std::find(_parameters->cbegin(), _parameters->cend(), variable->symbol()) == _parameters->cend())
+			_is_read[variable->symbol()] = true;
+	}
+
+	virtual void visit_call(const ast_call* call) {
+		if (find_unary_standard_function(call->name()) != nullptr || find_binary_standard_function(call->name()) != nullptr)
+			_standard_functions.insert(call->name());
+
+		visitor::visit_call(call);
+	}
+
+public:
+	folded_uses(size_t symbol_count) : _is_read(symbol_count, false) { }
+
+	void add(const ast_expression* expression, const std::vector<symbol_id>* parameters = nullptr) {
+		_parameters = parameters;
+		expression->accept(*this);
+		_parameters = nullptr;
+	}
+
+	bool is_read(symbol_id symbol) const { return _is_read[symbol]; }
+
+	const std::set<std::string>& standard_functions() const { return _standard_functions; }
+};
+
+table_registry constant_folder::fold(const table_registry& table_registry, const std::map<std::string, value>& inputs) {
+	auto& symbols = table_registry.symbols();
+	auto& output_types = table_registry.output_types();
+	auto input_types = table_registry.input_types();
+
+	_is_known.assign(symbols.size(), false);
+	_known_values.assign(symbols.size(), value());
+
+	for (auto i = inputs.cbegin(); i != inputs.cend(); i++) {
+		auto symbol = symbols.find(i->first);
+		if (symbol == no_symbol || input_types[symbol] == no_type || output_types[symbol] != no_type)
+			throw new std::runtime_error("Unknown input variable `" + i->first + "`.");
+
+		_is_known[symbol] = true;
+		_known_values[symbol] = i->second.cast_to(input_types[symbol]);
+	}
+
+	folded_uses uses(symbols.size());
+
+	// Functions may be called before any assignment, so only specialized inputs are known in them.
+	std::vector<const ast_function*> functions;
+	for (auto i = table_registry.functions().cbegin(); i != table_registry.functions().cend(); i++) {
+		auto function = *i;
+
+		_parameters = &function->parameter_symbols();
+		auto expression = fold(function->expression()).expression;
+		_parameters = nullptr;
+
+		if (expression != function->expression())
+			function = _arena.create<ast_function>(function->symbol(), function->name(), function->parameters(),
+				function->parameter_symbols(), expression);
+
+		uses.add(function->expression(), &function->parameter_symbols());
+		functions.push_back(function);
+	}
+
+	std::vector<const ast_assignment*> assignments;
+	for (auto i = table_registry.assignments().cbegin(); i != table_registry.assignments().cend(); i++) {
+		auto assignment = *i;
+		auto folded_expression = fold(assignment->expression());
+
+		if (folded_expression.expression != assignment->expression())
+			assignment = _arena.create<ast_assignment>(assignment->symbol(), assignment->name(), folded_expression.expression);
+
+		if (folded_expression.is_constant) {
+			_is_known[assignment->symbol()] = true;
+			_known_values[assignment->symbol()] = folded_expression.constant;
+		}
+
+		uses.add(assignment->expression());
+		assignments.push_back(assignment);
+	}
+
+	// Inputs nobody reads any more are neither prompted for nor loaded.
+	for (symbol_id i = 0; i < (symbol_id)input_types.size(); i++) {
+		if (output_types[i] == no_type && !uses.is_read(i))
+			input_types[i] = no_type;
+	}
+
+	return ::table_registry(&symbols, input_types, output_types, uses.standard_functions(), functions, assignments);
+}
+
+constant_folder::folded constant_folder::fold(const ast_expression* expression) {
+	expression->accept(*this);
+
+	auto result = _expressions.top();
+	_expressions.pop();
+
+	return result;
+}
+
+constant_folder::folded_condition constant_folder::fold(const ast_logical_expression* logical_expression) {
+	logical_expression->accept(*this);
+
+	auto result = _conditions.top();
+	_conditions.pop();
+
+	return result;
+}
+
+bool constant_folder::is_parameter(symbol_id symbol) const {
+	return _parameters != nullptr && std::find(_parameters->cbegin(), _parameters->cend(), symbol) != _parameters->cend();
+}
+
+constant_folder::folded constant_folder::make_constant(value constant) {
+	const ast_expression* expression;
+	if (constant.type() == expression_type::Double)
+		expression = _arena.create<ast_double>(constant.as_double());
+	else
+		expression = _arena.create<ast_long>(constant.as_long());
+
+	return folded{ expression, true, constant, nullptr };
+}
+
+constant_folder::folded constant_folder::make_expression(const ast_expression* expression) {
+	return folded{ expression, false, value(), nullptr };
+}
+
+constant_folder::folded constant_folder::promote(folded operand, expression_type type) {
+	if (!operand.is_constant || operand.constant.type() == type)
+		return operand;
+
+	return make_constant(operand.constant.cast_to(type));
+}
+
+void constant_folder::visit_long(const ast_long* _long) {
+	_expressions.push(folded{ _long, true, value(_long->value()), nullptr });
+}
+
+void constant_folder::visit_double(const ast_double* _double) {
+	_expressions.push(folded{ _double, true, value(_double->value()), nullptr });
+}
+
+void constant_folder::visit_variable(const ast_variable* variable) {
+	auto symbol = variable->symbol();
+	if (_is_known[symbol] && !is_parameter(symbol)) {
+		_expressions.push(make_constant(_known_values[symbol].cast_to(variable->type())));
+
+		return;
+	}
+
+	_expressions.push(make_expression(variable));
+}
+
+void constant_folder::visit_call(const ast_call* call) {
+	auto unary_function = find_unary_standard_function(call->name());
+	auto binary_function = find_binary_standard_function(call->name());
+	bool is_standard_function = unary_function != nullptr || binary_function != nullptr;
+
+	std::vector<folded> arguments;
+	bool is_constant = true;
+	bool is_changed = false;
+	for (auto i = call->parameters().cbegin(); i != call->parameters().cend(); i++) {
+		auto argument = fold(*i);
+		if (is_standard_function)
+			argument = promote(argument, expression_type::Double);
+
+		is_constant = is_constant && argument.is_constant;
+		is_changed = is_changed || argument.expression != *i;
+		arguments.push_back(argument);
+	}
+
+	if (is_standard_function && is_constant) {
+		if (unary_function != nullptr)
+			_expressions.push(make_constant(value(unary_function(arguments[0].constant.as_double()))));
+		else
+			_expressions.push(make_constant(value(binary_function(arguments[0].constant.as_double(), arguments[1].constant.as_double()))));
+
+		return;
+	}
+
+	if (!is_changed) {
+		_expressions.push(make_expression(call));
+
+		return;
+	}
+
+	std::vector<const ast_expression*> parameters;
+	for (auto i = arguments.cbegin(); i != arguments.cend(); i++)
+		parameters.push_back(i->expression);
+
+	auto folded_call = _arena.create<ast_call>(call->symbol(), call->name(), parameters);
+	folded_call->set_type(call->type());
+
+	_expressions.push(make_expression(folded_call));
+}
+
+void constant_folder::visit_unary_operator(const ast_unary_operator* unary_operator) {
+	auto operand = fold(unary_operator->operand());
+
+	if (unary_operator->operation() == unary_operation::Positive) {
+		_expressions.push(operand);
+
+		return;
+	}
+
+	if (operand.is_constant) {
+		_expressions.push(make_constant(calculate(unary_operation::Negative, operand.constant)));
+
+		return;
+	}
+
+	if (operand.negated != nullptr) {
+		_expressions.push(make_expression(operand.negated));
+
+		return;
+	}
+
+	const ast_expression* expression = unary_operator;
+	if (operand.expression != unary_operator->operand())
+		expression = _arena.create<ast_unary_operator>(unary_operation::Negative, operand.expression);
+
+	_expressions.push(folded{ expression, false, value(), operand.expression });
+}
+
+void constant_folder::visit_binary_operator(const ast_binary_operator* binary_operator) {
+	auto type = binary_operator->type();
+	auto operation = binary_operator->operation();
+	auto left = promote(fold(binary_operator->left()), type);
+	auto right = promote(fold(binary_operator->right()), type);
+
+	if (left.is_constant && right.is_constant) {
+		// Integer division by zero and overflowing division are left for run time.
+		bool is_division = operation == binary_operation::Divide || operation == binary_operation::Reminder;
+		bool is_undefined = type == expression_type::Long && is_division
+			&& (right.constant.as_long() == 0 || (right.constant.as_long() == -1 && left.constant.as_long() == LONG_MIN));
+
+		if (!is_undefined) {
+			_expressions.push(make_constant(calculate(operation, left.constant, right.constant).cast_to(type)));
+
+			return;
+		}
+	}
+
+	// Identities apply only if the other operand has the type of the result already.
+	bool is_left_exact = left.expression->type() == type;
+	bool is_right_exact = right.expression->type() == type;
+	auto is_equal = [](const folded& operand, double number) { return operand.is_constant && operand.constant.as_double() == number; };
+	bool is_left_one = is_equal(left, 1.0);
+	bool is_right_one = is_equal(right, 1.0);
+	bool is_left_zero = is_equal(left, 0.0);
+	bool is_right_zero = is_equal(right, 0.0);
+
+	const ast_expression* identity = nullptr;
+	switch (operation) {
+	case binary_operation::Add:
+		if (type == expression_type::Long && is_right_zero && is_left_exact)
+			identity = left.expression;
+		else if (type == expression_type::Long && is_left_zero && is_right_exact)
+			identity = right.expression;
+		break;
+	case binary_operation::Subtract:
+		if (is_right_zero && is_left_exact)
+			identity = left.expression;
+		break;
+	case binary_operation::Multiply:
+		if (is_right_one && is_left_exact)
+			identity = left.expression;
+		else if (is_left_one && is_right_exact)
+			identity = right.expression;
+		break;
+	case binary_operation::Divide:
+		if (is_right_one && is_left_exact)
+			identity = left.expression;
+		break;
+	default:
+		break;
+	}
+
+	if (identity != nullptr) {
+		_expressions.push(make_expression(identity));
+
+		return;
+	}
+
+	if (left.expression == binary_operator->left() && right.expression == binary_operator->right()) {
+		_expressions.push(make_expression(binary_operator));
+
+		return;
+	}
+
+	_expressions.push(make_expression(_arena.create<ast_binary_operator>(operation, left.expression, right.expression)));
+}
+
+void constant_folder::visit_logical_binary_operator(const ast_logical_binary_operator* logical_binary_operator) {
+	bool is_or = logical_binary_operator->operation() == "or";
+	auto left = fold(logical_binary_operator->left());
+
+	// A constant left operand decides the result or leaves the right one. A constant right
+	// operand can't remove the left one, which may fail at run time.
+	if (left.is_constant) {
+		if (left.constant == is_or)
+			_conditions.push(left);
+		else
+			_conditions.push(fold(logical_binary_operator->right()));
+
+		return;
+	}
+
+	auto right = fold(logical_binary_operator->right());
+	if (right.is_constant && right.constant != is_or) {
+		_conditions.push(left);
+
+		return;
+	}
+
+	if (left.expression == logical_binary_operator->left() && right.expression == logical_binary_operator->right())
+		_conditions.push(folded_condition{ logical_binary_operator, false, false });
+	else
+		_conditions.push(folded_condition{ _arena.create<ast_logical_binary_operator>(logical_binary_operator->operation(),
+			left.expression, right.expression), false, false });
+}
+
+void constant_folder::visit_logical_not_operator(const ast_logical_not_operator* logical_not_operator) {
+	auto operand = fold(logical_not_operator->operand());
+
+	const ast_logical_expression* expression = logical_not_operator;
+	if (operand.expression != logical_not_operator->operand())
+		expression = _arena.create<ast_logical_not_operator>(operand.expression);
+
+	_conditions.push(folded_condition{ expression, operand.is_constant, !operand.constant });
+}
+
+void constant_folder::visit_condition(const ast_condition* condition) {
+	auto left = fold(condition->left());
+	auto right = fold(condition->right());
+
+	const ast_logical_expression* expression = condition;
+	if (left.expression != condition->left() || right.expression != condition->right())
+		expression = _arena.create<ast_condition>(condition->operation(), left.expression, right.expression);
+
+	bool is_constant = left.is_constant && right.is_constant;
+	bool constant = is_constant && compare(condition->operation(), left.constant, right.constant);
+
+	_conditions.push(folded_condition{ expression, is_constant, constant });
+}
+
+void constant_folder::visit_if_then_else(const ast_if_then_else* if_then_else) {
+	auto type = if_then_else->type();
+	auto logical_expression = fold(if_then_else->logical_expression());
+
+	// Only the taken branch is left. A `long` branch of a `double` expression is converted
+	// by adding 0.0, which is exact for every integer.
+	if (logical_expression.is_constant) {
+		auto taken = fold(logical_expression.constant ? if_then_else->then_expression() : if_then_else->else_expression());
+		taken = promote(taken, type);
+
+		if (taken.expression->type() != type)
+			taken = make_expression(_arena.create<ast_binary_operator>(binary_operation::Add, taken.expression, _arena.create<ast_double>(0.0)));
+
+		_expressions.push(taken);
+
+		return;
+	}
+
+	auto then_expression = fold(if_then_else->then_expression()).expression;
+	auto else_expression = fold(if_then_else->else_expression()).expression;
+
+	if (logical_expression.expression == if_then_else->logical_expression() && then_expression == if_then_else->then_expression()
+		&& else_expression == if_then_else->else_expression()) {
+		_expressions.push(make_expression(if_then_else));
+
+		return;
+	}
+
+	_expressions.push(make_expression(_arena.create<ast_if_then_else>(logical_expression.expression, then_expression, else_expression)));
+}
@@ -0,0 +1,97 @@
+#ifndef __CONSTANT_FOLDER_H__
+#define __CONSTANT_FOLDER_H__
+
+#include <map>
+#include <set>
+#include <stack>
+#include <string>
+#include <vector>
+
+#include "arena.h"
+#include "ast.h"
+#include "table_registry.h"
+#include "value.h"
+
+// Evaluates constant operators and standard function calls at compile time and removes
+// operations which never change a value: `x * 1`, `x / 1`, `x - 0`, `--x`, `+x` and `x + 0`
+// for `long`. (`x + 0.0` would change -0.0.) `long` constants used as `double` operands
+// become `double` constants, so the generator never converts them at run time.
+//
+// Conditions of constant operands are decided at compile time, so only the taken branch of
+// such an if-then-else is left. An assignment folded to a constant is propagated into the
+// following assignments.
+//
+// Folding keeps the type of every expression. Integer division by a constant zero is left
+// to fail at run time. Changed nodes are created in the arena of the program, unchanged
+// subtrees are shared with the original tree.
+class constant_folder : private visitor
+{
+public:
+	constant_folder(arena& arena) : _arena(arena), _parameters(nullptr) { }
+
+	// Returns the registry with folded assignments and functions. Standard functions and
+	// input variables which are not used any more are removed from it.
+	//
+	// Input variables listed in `inputs` are specialized: their reads become constants.
+	table_registry fold(const table_registry& table_registry, const std::map<std::string, value>& inputs = std::map<std::string, value>());
+
+private:
+	struct folded
+	{
+		const ast_expression* expression;
+		bool is_constant;
+		value constant;
+		// `x` for `-x`, so `--x` becomes `x`.
+		const ast_expression* negated;
+	};
+
+	struct folded_condition
+	{
+		const ast_logical_expression* expression;
+		bool is_constant;
+		bool constant;
+	};
+
+	arena& _arena;
+	// Values of variables known at compile time, indexed by symbol ids.
+	std::vector<bool> _is_known;
+	std::vector<value> _known_values;
+	const std::vector<symbol_id>* _parameters;
+	std::stack<folded> _expressions;
+	std::stack<folded_condition> _conditions;
+
+	folded fold(const ast_expression* expression);
+
+	folded_condition fold(const ast_logical_expression* logical_expression);
+
+	bool is_parameter(symbol_id symbol) const;
+
+	folded make_constant(value constant);
+
+	folded make_expression(const ast_expression* expression);
+
+	// Converts a `long` constant to `double` if the operation is computed in `double`.
+	folded promote(folded operand, expression_type type);
+
+	virtual void visit_long(const ast_long* _long);
+
+	virtual void visit_double(const ast_double* _double);
+
+	virtual void visit_variable(const ast_variable* variable);
+
+	virtual void visit_call(const ast_call* call);
+
+	virtual void visit_unary_operator(const ast_unary_operator* unary_operator);
+
+	virtual void visit_binary_operator(const ast_binary_operator* binary_operator);
+
+	virtual void visit_logical_binary_operator(const ast_logical_binary_operator* logical_binary_operator);
+
+	virtual void visit_logical_not_operator(const ast_logical_not_operator* logical_not_operator);
+
+	virtual void visit_condition(const ast_condition* condition);
+
+	virtual void visit_if_then_else(const ast_if_then_else* if_then_else);
+};
+
+#endif
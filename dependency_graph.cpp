@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+#include "dependency_graph.h"
+#include "value.h"
+
+// Collects static variables an expression reads and functions it calls.
+class expression_reads : private visitor
+{
+private:
+	const std::vector<symbol_id>* _parameters;
+	std::set<symbol_id> _variables;
+	std::set<std::string> _callees;
+	std::set<std::string> _standard_functions;
+
+	virtual void visit_variable(const ast_variable* variable) {
+		if (std::find(_parameters->cbegin(), _parameters->cend(), variable->symbol()) == _parameters->cend())
+			_variables.insert(variable->symbol());
+	}
+
+	virtual void visit_call(const ast_call* call) {
+		bool is_standard_function = find_unary_standard_function(call->name()) != nullptr
+			|| find_binary_standard_function(call->name()) != nullptr;
+
+		if (is_standard_function)
+			_standard_functions.insert(call->name());
+		else
+			_callees.insert(call->name());
+
+		visitor::visit_call(call);
+	}
+
+public:
+	expression_reads(const ast_expression* expression, const std::vector<symbol_id>& parameters) : _parameters(&parameters) {
+		expression->accept(*this);
+	}
+
+	const std::set<symbol_id>& variables() const { return _variables; }
+
+	const std::set<std::string>& callees() const { return _callees; }
+
+	const std::set<std::string>& standard_functions() const { return _standard_functions; }
+};
+
+// Adds variables read by the function and by all the functions it calls to `variables`.
+// Names of all these functions are added to `visited`.
+static void add_function_reads(const std::string& name, const std::map<std::string, expression_reads>& functions,
+	std::set<std::string>& visited, std::set<symbol_id>& variables) {
+	auto function = functions.find(name);
+	if (function == functions.end() || !visited.insert(name).second)
+		return;
+
+	variables.insert(function->second.variables().cbegin(), function->second.variables().cend());
+
+	for (auto i = function->second.callees().cbegin(); i != function->second.callees().cend(); i++)
+		add_function_reads(*i, functions, visited, variables);
+}
+
+static std::map<std::string, expression_reads> read_functions(const table_registry& table_registry) {
+	std::map<std::string, expression_reads> functions;
+	for (auto i = table_registry.functions().cbegin(); i != table_registry.functions().cend(); i++)
+		functions.emplace((*i)->name(), expression_reads((*i)->expression(), (*i)->parameter_symbols()));
+
+	return functions;
+}
+
+dependency_graph::dependency_graph(const table_registry& table_registry) {
+	_assignments = table_registry.assignments();
+	_predecessors.resize(_assignments.size());
+	_data_predecessors.resize(_assignments.size());
+	_successors.resize(_assignments.size());
+
+	auto functions = read_functions(table_registry);
+
+	const std::vector<symbol_id> no_parameters;
+	std::map<symbol_id, size_t> last_assignments;
+	std::map<symbol_id, std::vector<size_t>> reads_since_assignment;
+	std::vector<size_t> levels(_assignments.size(), 0);
+
+	for (size_t i = 0; i < _assignments.size(); i++) {
+		auto assignment = _assignments[i];
+		expression_reads reads(assignment->expression(), no_parameters);
+
+		std::set<symbol_id> variables = reads.variables();
+		std::set<std::string> visited;
+		for (auto j = reads.callees().cbegin(); j != reads.callees().cend(); j++)
+			add_function_reads(*j, functions, visited, variables);
+
+		auto& data_predecessors = _data_predecessors[i];
+		for (auto j = variables.cbegin(); j != variables.cend(); j++) {
+			auto last_assignment = last_assignments.find(*j);
+			if (last_assignment != last_assignments.end())
+				data_predecessors.push_back(last_assignment->second);
+			else
+				_input_readers[*j].push_back(i);
+		}
+
+		std::sort(data_predecessors.begin(), data_predecessors.end());
+		data_predecessors.erase(std::unique(data_predecessors.begin(), data_predecessors.end()), data_predecessors.end());
+
+		auto& predecessors = _predecessors[i];
+		predecessors = data_predecessors;
+
+		auto last_assignment = last_assignments.find(assignment->symbol());
+		if (last_assignment != last_assignments.end())
+			predecessors.push_back(last_assignment->second);
+
+		auto& overwritten_reads = reads_since_assignment[assignment->symbol()];
+		predecessors.insert(predecessors.end(), overwritten_reads.cbegin(), overwritten_reads.cend());
+
+		std::sort(predecessors.begin(), predecessors.end());
+		predecessors.erase(std::unique(predecessors.begin(), predecessors.end()), predecessors.end());
+
+		for (auto j = variables.cbegin(); j != variables.cend(); j++)
+			reads_since_assignment[*j].push_back(i);
+
+		reads_since_assignment[assignment->symbol()].clear();
+		last_assignments[assignment->symbol()] = i;
+
+		for (auto j = predecessors.cbegin(); j != predecessors.cend(); j++) {
+			_successors[*j].push_back(i);
+			levels[i] = std::max(levels[i], levels[*j] + 1);
+		}
+
+		if (levels[i] == _levels.size())
+			_levels.emplace_back();
+
+		_levels[levels[i]].push_back(assignment);
+	}
+}
+
+std::vector<size_t> dependency_graph::input_readers(symbol_id variable) const {
+	auto readers = _input_readers.find(variable);
+	if (readers == _input_readers.end())
+		return std::vector<size_t>();
+
+	return readers->second;
+}
+
+std::vector<const ast_assignment*> dependency_graph::locality_order() const {
+	std::vector<const ast_assignment*> order;
+	std::vector<bool> is_placed(_assignments.size(), false);
+
+	// Assignments nobody depends on are placed in the source order, each one right
+	// after the assignments it needs that are not placed yet.
+	for (size_t i = 0; i < _assignments.size(); i++) {
+		if (_successors[i].empty())
+			place(i, is_placed, order);
+	}
+
+	return order;
+}
+
+void dependency_graph::place(size_t assignment, std::vector<bool>& is_placed,
+	std::vector<const ast_assignment*>& order) const {
+	if (is_placed[assignment])
+		return;
+
+	is_placed[assignment] = true;
+
+	auto& predecessors = _predecessors[assignment];
+	for (auto i = predecessors.cbegin(); i != predecessors.cend(); i++)
+		place(*i, is_placed, order);
+
+	order.push_back(_assignments[assignment]);
+}
+
+table_registry slice_outputs(const table_registry& table_registry, const std::vector<std::string>& outputs) {
+	auto& symbols = table_registry.symbols();
+	dependency_graph graph(table_registry);
+
+	std::map<symbol_id, size_t> assignment_indices;
+	for (size_t i = 0; i < graph.assignments().size(); i++)
+		assignment_indices[graph.assignments()[i]->symbol()] = i;
+
+	std::vector<bool> is_needed(graph.assignments().size(), false);
+	std::vector<size_t> pending;
+	for (auto i = outputs.cbegin(); i != outputs.cend(); i++) {
+		auto assignment = assignment_indices.find(symbols.find(*i));
+		if (assignment == assignment_indices.end())
+			throw new std::runtime_error("Unknown output variable `" + *i + "`.");
+
+		pending.push_back(assignment->second);
+	}
+
+	while (!pending.empty()) {
+		size_t assignment = pending.back();
+		pending.pop_back();
+
+		if (is_needed[assignment])
+			continue;
+
+		is_needed[assignment] = true;
+		pending.insert(pending.end(), graph.data_predecessors(assignment).cbegin(), graph.data_predecessors(assignment).cend());
+	}
+
+	// Types of variables, functions and standard functions are recollected from the needed assignments only.
+	auto functions = read_functions(table_registry);
+	const std::vector<symbol_id> no_parameters;
+	std::vector<const ast_assignment*> assignments;
+	std::set<symbol_id> variables;
+	std::set<std::string> callees;
+	std::set<std::string> standard_functions;
+	std::vector<expression_type> input_types(table_registry.input_types().size(), no_type);
+	std::vector<expression_type> output_types(table_registry.output_types().size(), no_type);
+
+	for (size_t i = 0; i < graph.assignments().size(); i++) {
+		if (!is_needed[i])
+			continue;
+
+		auto assignment = graph.assignments()[i];
+		expression_reads reads(assignment->expression(), no_parameters);
+
+		variables.insert(reads.variables().cbegin(), reads.variables().cend());
+		standard_functions.insert(reads.standard_functions().cbegin(), reads.standard_functions().cend());
+		for (auto j = reads.callees().cbegin(); j != reads.callees().cend(); j++)
+			add_function_reads(*j, functions, callees, variables);
+
+		assignments.push_back(assignment);
+		output_types[assignment->symbol()] = table_registry.output_types()[assignment->symbol()];
+	}
+
+	// A variable read before its assignment is assigned in the program too, so it is neither
+	// an input nor an output. Its assignment is left out of the slice, the reads see the
+	// initial value anyway.
+	for (auto i = variables.cbegin(); i != variables.cend(); i++) {
+		input_types[*i] = table_registry.input_types()[*i];
+
+		if (output_types[*i] == no_type)
+			output_types[*i] = table_registry.output_types()[*i];
+	}
+
+	// Requested outputs are printed even when other needed assignments read them.
+	for (auto i = outputs.cbegin(); i != outputs.cend(); i++)
+		input_types[symbols.find(*i)] = no_type;
+
+	std::vector<const ast_function*> needed_functions;
+	for (auto i = table_registry.functions().cbegin(); i != table_registry.functions().cend(); i++) {
+		if (callees.find((*i)->name()) == callees.end())
+			continue;
+
+		auto& function_standard_functions = functions.at((*i)->name()).standard_functions();
+		standard_functions.insert(function_standard_functions.cbegin(), function_standard_functions.cend());
+		needed_functions.push_back(*i);
+	}
+
+	return ::table_registry(&symbols, input_types, output_types, standard_functions, needed_functions, assignments);
+}
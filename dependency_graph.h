@@ -0,0 +1,61 @@
+#ifndef __DEPENDENCY_GRAPH_H__
+#define __DEPENDENCY_GRAPH_H__
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "table_registry.h"
+
+// Dependencies between assignments. An assignment depends on the last preceding
+// assignment of every variable it reads, directly or through the user functions it
+// calls, on the preceding reads of the variable it overwrites and on its previous
+// assignment. Any order respecting the dependencies computes the same outputs.
+class dependency_graph
+{
+public:
+	dependency_graph(const table_registry& table_registry);
+
+	// Assignments in the source order, indices below refer to them.
+	const std::vector<const ast_assignment*>& assignments() const { return _assignments; }
+
+	// Indices of the assignments the assignment depends on in ascending order.
+	const std::vector<size_t>& predecessors(size_t assignment) const { return _predecessors[assignment]; }
+
+	const std::vector<size_t>& successors(size_t assignment) const { return _successors[assignment]; }
+
+	// Indices of the assignments whose values the assignment reads in ascending order. The
+	// reads it overwrites are ordering constraints, not data, so they are not included.
+	const std::vector<size_t>& data_predecessors(size_t assignment) const { return _data_predecessors[assignment]; }
+
+	// Indices of the assignments reading the input value of the variable, i.e. the value
+	// it has before all the assignments, in ascending order.
+	std::vector<size_t> input_readers(symbol_id variable) const;
+
+	// Groups of independent assignments. Assignments of a group depend on assignments
+	// of the previous groups only, so a group can be executed in any order or at once.
+	const std::vector<std::vector<const ast_assignment*>>& levels() const { return _levels; }
+
+	// Topological order where every assignment is placed right before the first one
+	// using it, so values are consumed shortly after they are computed.
+	std::vector<const ast_assignment*> locality_order() const;
+
+private:
+	std::vector<const ast_assignment*> _assignments;
+	std::vector<std::vector<size_t>> _predecessors;
+	std::vector<std::vector<size_t>> _data_predecessors;
+	std::vector<std::vector<size_t>> _successors;
+	std::map<symbol_id, std::vector<size_t>> _input_readers;
+	std::vector<std::vector<const ast_assignment*>> _levels;
+
+	void place(size_t assignment, std::vector<bool>& is_placed, std::vector<const ast_assignment*>& order) const;
+};
+
+// Returns the registry with only the assignments, functions and standard functions the
+// outputs transitively read (backward slice over data_predecessors()). The outputs are
+// its only printed variables, and the variables they read are its only inputs, except
+// variables read before their assignment, which keep their initial value.
+table_registry slice_outputs(const table_registry& table_registry, const std::vector<std::string>& outputs);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef __EVALUATION_OPTIONS_H__
+#define __EVALUATION_OPTIONS_H__
+
+#include <string>
+#include <vector>
+
+enum class evaluation_engine
+{
+	TreeWalk,
+	Bytecode,
+	Jit,
+};
+
+struct evaluation_options
+{
+	evaluation_engine engine = evaluation_engine::TreeWalk;
+
+	// Every JIT-compiled function is registered in /tmp/perf-<pid>.map, so `perf` can resolve its name.
+	bool perf_map = false;
+
+	// Pure recursive functions of `long` parameters are JIT-compiled with a memo table,
+	// so repeated calls with the same arguments are not recomputed.
+	bool memoize = false;
+
+	// The tree-walking evaluator executes independent assignments on this many threads.
+	int threads = 1;
+
+	// After the first evaluation the tree-walking evaluator reads lines of changed inputs
+	// and recomputes only what depends on them (see evaluate_incrementally()).
+	bool incremental = false;
+
+	// When not empty, only these outputs and what they need are evaluated.
+	std::vector<std::string> outputs;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "bytecode_compiler.h"
+#include "bytecode_vm.h"
+#include "dependency_graph.h"
+#include "evaluator.h"
+#include "jit_engine.h"
+#include "step1_tables_builder.h"
+#include "step2_evaluator.h"
+
+std::map<std::string, value> parse_inputs(const std::map<std::string, std::string>& arguments,
+	const std::map<std::string, expression_type>& input_variables) {
+	std::map<std::string, value> inputs;
+	for (auto i = arguments.cbegin(); i != arguments.cend(); i++) {
+		auto input = input_variables.find(i->first);
+		if (input == input_variables.end())
+			throw new std::runtime_error("Unknown input variable `" + i->first + "`.");
+
+		inputs[i->first] = parse_value(i->second, input->second);
+	}
+
+	return inputs;
+}
+
+static void print_outputs(const std::map<std::string, value>& outputs, std::ostream& out) {
+	for (auto i = outputs.cbegin(); i != outputs.cend(); i++)
+		out << i->first << " = " << i->second.to_string() << std::endl;
+}
+
+void evaluate(const ast_program* program, const std::map<std::string, std::string>& arguments, std::ostream& out,
+	const evaluation_options& options) {
+	step1_tables_builder builder;
+	auto table_registry = builder.build(program);
+	if (!options.outputs.empty())
+		table_registry = slice_outputs(table_registry, options.outputs);
+
+	std::map<std::string, value> outputs;
+	if (options.engine == evaluation_engine::Bytecode) {
+		bytecode_compiler compiler;
+		bytecode_vm vm(compiler.compile(table_registry));
+
+		outputs = vm.evaluate(parse_inputs(arguments, vm.input_variables()));
+	}
+	else if (options.engine == evaluation_engine::Jit) {
+#ifdef COMCALC_LLVM
+		jit_engine jit(table_registry, options);
+
+		outputs = jit.evaluate(parse_inputs(arguments, jit.input_variables()));
+#else
+		throw new std::runtime_error("JIT is not available: comcalc is built without LLVM (COMCALC_LLVM).");
+#endif
+	}
+	else {
+		step2_evaluator evaluator(table_registry, options.threads);
+
+		outputs = evaluator.evaluate(parse_inputs(arguments, evaluator.input_variables()));
+	}
+
+	print_outputs(outputs, out);
+}
+
+void evaluate_incrementally(const ast_program* program, const std::map<std::string, std::string>& arguments,
+	std::istream& in, std::ostream& out, const evaluation_options& options) {
+	step1_tables_builder builder;
+	auto table_registry = builder.build(program);
+	if (!options.outputs.empty())
+		table_registry = slice_outputs(table_registry, options.outputs);
+
+	step2_evaluator evaluator(table_registry, options.threads);
+
+	print_outputs(evaluator.evaluate(parse_inputs(arguments, evaluator.input_variables())), out);
+	out << std::endl;
+
+	std::string line;
+	while (std::getline(in, line)) {
+		try {
+			std::istringstream pairs(line);
+			std::map<std::string, std::string> changed_arguments;
+			std::string pair;
+
+			while (pairs >> pair) {
+				size_t equal_position = pair.find('=');
+				if (equal_position == std::string::npos || equal_position == 0)
+					throw new std::runtime_error("Invalid input `" + pair + "`, `name=value` is expected.");
+
+				changed_arguments[pair.substr(0, equal_position)] = pair.substr(equal_position + 1);
+			}
+
+			print_outputs(evaluator.update(parse_inputs(changed_arguments, evaluator.input_variables())), out);
+		}
+		catch (std::exception* exception) {
+			std::cerr << exception->what() << std::endl;
+			delete exception;
+		}
+
+		out << std::endl;
+	}
+}
@@ -0,0 +1,22 @@
+#ifndef __EVALUATOR_H__
+#define __EVALUATOR_H__
+
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "ast.h"
+#include "evaluation_options.h"
+
+void evaluate(const ast_program* program, const std::map<std::string, std::string>& arguments, std::ostream& out,
+	const evaluation_options& options = evaluation_options());
+
+// Evaluates the program like evaluate(), then reads lines of `name=value` pairs of changed
+// inputs until EOF. After every line only the affected assignments are recomputed, and
+// the outputs that changed are printed followed by an empty line. A line which fails is
+// reported to stderr and changes nothing, the following lines are evaluated as usual.
+void evaluate_incrementally(const ast_program* program, const std::map<std::string, std::string>& arguments,
+	std::istream& in, std::ostream& out, const evaluation_options& options = evaluation_options());
+
+#endif
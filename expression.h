@@ -1,6 +1,7 @@
 #ifndef __EXPRESSION_H__
 #define __EXPRESSION_H__
 
+#include <stdexcept>
 #include <string>
 
 enum class expression_type
@@ -9,7 +10,10 @@ enum class expression_type
 	Double,
 };
 
-std::string to_string(expression_type type) {
+// Marks the absence of a type, e.g. in tables indexed by symbol ids.
+const expression_type no_type = (expression_type)0;
+
+inline std::string to_string(expression_type type) {
 	if (type == expression_type::Long)
 		return "long";
 
@@ -0,0 +1,158 @@
+#include <cstring>
+
+#include "expression_dag.h"
+#include "value.h"
+
+enum class dag_node_kind
+{
+	Long,
+	Double,
+	Variable,
+	Call,
+	Unary,
+	Binary,
+};
+
+bool expression_dag::node_key::operator==(const node_key& other) const {
+	return kind == other.kind && data == other.data && version == other.version
+		&& left == other.left && right == other.right && parameters == other.parameters;
+}
+
+size_t expression_dag::node_key_hash::operator()(const node_key& key) const {
+	size_t hash = std::hash<int>()(key.kind);
+	hash = hash * 31 + std::hash<int64_t>()(key.data);
+	hash = hash * 31 + std::hash<int64_t>()(key.version);
+	hash = hash * 31 + std::hash<const void*>()(key.left);
+	hash = hash * 31 + std::hash<const void*>()(key.right);
+
+	for (auto i = key.parameters.cbegin(); i != key.parameters.cend(); i++)
+		hash = hash * 31 + std::hash<const void*>()(*i);
+
+	return hash;
+}
+
+table_registry expression_dag::build(const table_registry& table_registry) {
+	_nodes.clear();
+	_versions.assign(table_registry.symbols().size(), 0);
+
+	std::vector<const ast_assignment*> assignments;
+	for (auto i = table_registry.assignments().cbegin(); i != table_registry.assignments().cend(); i++) {
+		auto assignment = *i;
+		auto expression = share(assignment->expression());
+
+		if (expression != assignment->expression())
+			assignment = _arena.create<ast_assignment>(assignment->symbol(), assignment->name(), expression);
+
+		assignments.push_back(assignment);
+		_versions[assignment->symbol()]++;
+	}
+
+	return ::table_registry(&table_registry.symbols(), table_registry.input_types(), table_registry.output_types(),
+		table_registry.standard_functions(), table_registry.functions(), assignments);
+}
+
+const ast_expression* expression_dag::share(const ast_expression* expression) {
+	expression->accept(*this);
+
+	auto result = _expressions.top();
+	_expressions.pop();
+
+	return result;
+}
+
+const ast_expression* expression_dag::intern(const node_key& key, const ast_expression* expression) {
+	auto node = _nodes.emplace(key, expression);
+
+	return node.first->second;
+}
+
+const ast_expression* expression_dag::find(const node_key& key) const {
+	auto node = _nodes.find(key);
+
+	return node != _nodes.end() ? node->second : nullptr;
+}
+
+void expression_dag::visit_long(const ast_long* _long) {
+	_expressions.push(intern(node_key{ (int)dag_node_kind::Long, _long->value(), 0, nullptr, nullptr, {} }, _long));
+}
+
+void expression_dag::visit_double(const ast_double* _double) {
+	// Bits tell 0.0 from -0.0.
+	double value = _double->value();
+	int64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	_expressions.push(intern(node_key{ (int)dag_node_kind::Double, bits, 0, nullptr, nullptr, {} }, _double));
+}
+
+void expression_dag::visit_variable(const ast_variable* variable) {
+	int64_t data = (int64_t)variable->symbol() * 2 + (variable->type() == expression_type::Double ? 1 : 0);
+
+	_expressions.push(intern(node_key{ (int)dag_node_kind::Variable, data, _versions[variable->symbol()], nullptr, nullptr, {} }, variable));
+}
+
+void expression_dag::visit_call(const ast_call* call) {
+	bool is_standard_function = find_unary_standard_function(call->name()) != nullptr
+		|| find_binary_standard_function(call->name()) != nullptr;
+
+	std::vector<const ast_expression*> parameters;
+	bool is_changed = false;
+	for (auto i = call->parameters().cbegin(); i != call->parameters().cend(); i++) {
+		parameters.push_back(share(*i));
+		is_changed = is_changed || parameters.back() != *i;
+	}
+
+	node_key key{ (int)dag_node_kind::Call, call->symbol(), 0, nullptr, nullptr, parameters };
+	const ast_expression* shared = is_standard_function ? find(key) : nullptr;
+	if (shared != nullptr) {
+		_expressions.push(shared);
+
+		return;
+	}
+
+	const ast_expression* expression = call;
+	if (is_changed) {
+		auto shared_call = _arena.create<ast_call>(call->symbol(), call->name(), parameters);
+		shared_call->set_type(call->type());
+		expression = shared_call;
+	}
+
+	_expressions.push(is_standard_function ? intern(key, expression) : expression);
+}
+
+void expression_dag::visit_unary_operator(const ast_unary_operator* unary_operator) {
+	auto operand = share(unary_operator->operand());
+
+	node_key key{ (int)dag_node_kind::Unary, (int64_t)unary_operator->operation(), 0, operand, nullptr, {} };
+	auto shared = find(key);
+	if (shared == nullptr) {
+		shared = unary_operator;
+		if (operand != unary_operator->operand())
+			shared = _arena.create<ast_unary_operator>(unary_operator->operation(), operand);
+
+		intern(key, shared);
+	}
+
+	_expressions.push(shared);
+}
+
+void expression_dag::visit_binary_operator(const ast_binary_operator* binary_operator) {
+	auto left = share(binary_operator->left());
+	auto right = share(binary_operator->right());
+
+	node_key key{ (int)dag_node_kind::Binary, (int64_t)binary_operator->operation(), 0, left, right, {} };
+	auto shared = find(key);
+	if (shared == nullptr) {
+		shared = binary_operator;
+		if (left != binary_operator->left() || right != binary_operator->right())
+			shared = _arena.create<ast_binary_operator>(binary_operator->operation(), left, right);
+
+		intern(key, shared);
+	}
+
+	_expressions.push(shared);
+}
+
+void expression_dag::visit_if_then_else(const ast_if_then_else* if_then_else) {
+	_expressions.push(if_then_else);
+}
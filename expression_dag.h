@@ -0,0 +1,72 @@
+#ifndef __EXPRESSION_DAG_H__
+#define __EXPRESSION_DAG_H__
+
+#include <cstdint>
+#include <stack>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.h"
+#include "ast.h"
+#include "table_registry.h"
+
+// Turns expression trees of all assignments into one DAG where structurally equal
+// subexpressions are the same node (hash consing), so the generator computes each of
+// them once. Constants, variables, unary and binary operators and standard function
+// calls are shared. A read of a variable after its assignment is a different node than
+// a read before it. If-then-else and calls of user functions are never shared.
+class expression_dag : private visitor
+{
+public:
+	expression_dag(arena& arena) : _arena(arena) { }
+
+	// Returns the registry with assignments over the shared nodes.
+	table_registry build(const table_registry& table_registry);
+
+private:
+	struct node_key
+	{
+		int kind;
+		int64_t data;
+		int64_t version;
+		const ast_expression* left;
+		const ast_expression* right;
+		std::vector<const ast_expression*> parameters;
+
+		bool operator==(const node_key& other) const;
+	};
+
+	struct node_key_hash
+	{
+		size_t operator()(const node_key& key) const;
+	};
+
+	arena& _arena;
+	std::unordered_map<node_key, const ast_expression*, node_key_hash> _nodes;
+	std::vector<int64_t> _versions;
+	std::stack<const ast_expression*> _expressions;
+
+	const ast_expression* share(const ast_expression* expression);
+
+	// Returns the shared node with the key, registering `expression` if there is none yet.
+	const ast_expression* intern(const node_key& key, const ast_expression* expression);
+
+	// Returns nullptr if there is no shared node with the key.
+	const ast_expression* find(const node_key& key) const;
+
+	virtual void visit_long(const ast_long* _long);
+
+	virtual void visit_double(const ast_double* _double);
+
+	virtual void visit_variable(const ast_variable* variable);
+
+	virtual void visit_call(const ast_call* call);
+
+	virtual void visit_unary_operator(const ast_unary_operator* unary_operator);
+
+	virtual void visit_binary_operator(const ast_binary_operator* binary_operator);
+
+	virtual void visit_if_then_else(const ast_if_then_else* if_then_else);
+};
+
+#endif
@@ -1,11 +1,68 @@
+#include <memory>
+#include <stdexcept>
+
+#include "compilation_cache.h"
+#include "compiler_statistics.h"
+#include "constant_folder.h"
+#include "dependency_graph.h"
+#include "expression_dag.h"
 #include "generator.h"
 #include "step1_tables_builder.h"
 #include "step2_generator.h"
 
-void generate(const ast_program* program, std::ostream& out) {
+void generate(const ast_program* program, std::ostream& out, const generator_options& options,
+	compiler_statistics* statistics) {
+	pass_timer step1_timer(statistics, "step1");
 	step1_tables_builder builder;
 	auto table_registry = builder.build(program);
+	step1_timer.stop();
+
+	std::map<std::string, value> specialized_inputs;
+	for (auto i = options.specialized_inputs.cbegin(); i != options.specialized_inputs.cend(); i++) {
+		auto input = table_registry.input_variables().find(i->first);
+		if (input == table_registry.input_variables().end()
+			|| table_registry.output_variables().find(i->first) != table_registry.output_variables().end())
+			throw new std::runtime_error("Unknown input variable `" + i->first + "`.");
+
+		specialized_inputs[i->first] = parse_value(i->second, input->second);
+	}
+
+	pass_timer fold_timer(statistics, "fold");
+	constant_folder folder(program->arena());
+	auto folded_registry = folder.fold(table_registry, specialized_inputs);
+	fold_timer.stop();
+
+	// Slicing follows folding, so dependencies removed by specialization are not followed.
+	if (!options.outputs.empty()) {
+		pass_timer timer(statistics, "slice");
+		folded_registry = slice_outputs(folded_registry, options.outputs);
+	}
 
-	step2_generator generator(table_registry, out);
+	pass_timer dag_timer(statistics, "dag");
+	expression_dag dag(program->arena());
+	auto shared_registry = dag.build(folded_registry);
+	dag_timer.stop();
+
+	std::unique_ptr<compilation_cache> cache;
+	if (!options.cache_path.empty()) {
+		pass_timer timer(statistics, "cache load");
+		cache.reset(new compilation_cache(options.cache_path));
+	}
+
+	auto start_position = out.tellp();
+	pass_timer step2_timer(statistics, "step2");
+	step2_generator generator(shared_registry, out, options, cache.get());
 	generator.print_code();
+	step2_timer.stop();
+
+	if (cache) {
+		pass_timer timer(statistics, "cache save");
+		cache->save();
+	}
+
+	if (statistics != nullptr) {
+		statistics->set_counter("ir_registers", generator.register_count());
+		if (start_position != std::streampos(-1))
+			statistics->set_counter("ir_bytes", (size_t)(out.tellp() - start_position));
+	}
 }
@@ -4,7 +4,11 @@
 #include <ostream>
 
 #include "ast.h"
+#include "compiler_statistics.h"
+#include "generator_options.h"
 
-void generate(const ast_program* program, std::ostream& out);
+// Passes are measured and sizes are counted into `statistics` when it is given.
+void generate(const ast_program* program, std::ostream& out, const generator_options& options = generator_options(),
+	compiler_statistics* statistics = nullptr);
 
 #endif
@@ -0,0 +1,29 @@
+#ifndef __GENERATOR_OPTIONS_H__
+#define __GENERATOR_OPTIONS_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct generator_options
+{
+	// Generated main() reads rows of inputs from stdin until EOF (no prompts)
+	// and prints one line of comma separated outputs per row.
+	bool batch = false;
+
+	// When greater than 1, a `kernel` function over column arrays is generated instead
+	// of main(). It computes `vector_width` rows per instruction.
+	int vector_width = 0;
+
+	// When not empty, only these outputs and what they need are generated.
+	std::vector<std::string> outputs;
+
+	// Values of input variables known at compile time. They become constants, so the
+	// generated code neither reads them nor computes what depends only on them.
+	std::map<std::string, std::string> specialized_inputs;
+
+	// When not empty, code of assignments is taken from and stored to this compilation cache file.
+	std::string cache_path;
+};
+
+#endif
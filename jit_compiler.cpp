@@ -0,0 +1,601 @@
+#ifdef COMCALC_LLVM
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "jit_compiler.h"
+#include "memoization.h"
+
+// Memoized functions of one parameter keep results for arguments in [0, memo_dense_size)
+// in arrays inside the module. Other arguments go to the memo_table of the engine.
+static const uint64_t memo_dense_size = 4096;
+
+jit_compiler::jit_compiler(llvm::LLVMContext& context, bool memoize)
+	: _context(context), _builder(context), _module(nullptr), _memoize(memoize), _loop_block(nullptr), _accumulator(nullptr) {
+}
+
+std::unique_ptr<llvm::Module> jit_compiler::compile(const table_registry& table_registry) {
+	auto module = std::make_unique<llvm::Module>("comcalc", _context);
+	_module = module.get();
+	_globals.clear();
+	_functions.clear();
+	_global_symbols.clear();
+	_function_symbols.clear();
+	_memo_table_symbols.clear();
+	_memoized_functions.clear();
+
+	if (_memoize)
+		_memoized_functions = find_memoizable_functions(table_registry);
+
+	_global_types = table_registry.input_variables();
+	auto output_variables = table_registry.output_variables();
+	_global_types.insert(output_variables.cbegin(), output_variables.cend());
+
+	for (auto i = _global_types.cbegin(); i != _global_types.cend(); i++) {
+		auto type = type_of(i->second);
+		auto global = new llvm::GlobalVariable(*_module, type, false, llvm::GlobalValue::ExternalLinkage,
+			llvm::Constant::getNullValue(type), i->first);
+
+		_globals[i->first] = global;
+		_global_symbols[i->first] = global->getName().str();
+	}
+
+	// All the functions are declared first, so they can call each other recursively.
+	auto functions = table_registry.functions();
+	for (auto i = functions.cbegin(); i != functions.cend(); i++) {
+		std::vector<llvm::Type*> parameter_types;
+		for (auto j = (*i)->parameters().cbegin(); j != (*i)->parameters().cend(); j++)
+			parameter_types.push_back(type_of(j->second));
+
+		auto function_type = llvm::FunctionType::get(type_of((*i)->expression()->type()), parameter_types, false);
+		auto function = llvm::Function::Create(function_type, llvm::Function::ExternalLinkage, (*i)->name(), _module);
+
+		_functions[(*i)->name()] = function;
+		_function_symbols[(*i)->name()] = function->getName().str();
+	}
+
+	for (auto i = functions.cbegin(); i != functions.cend(); i++)
+		compile_function(*i);
+
+	compile_assignments(table_registry.assignments());
+
+	std::string errors;
+	llvm::raw_string_ostream errors_stream(errors);
+	if (llvm::verifyModule(*_module, &errors_stream))
+		throw new std::runtime_error("Invalid JIT module: " + errors_stream.str());
+
+	_module = nullptr;
+
+	return module;
+}
+
+void jit_compiler::compile_assignments(const std::vector<const ast_assignment*>& assignments) {
+	auto function_type = llvm::FunctionType::get(llvm::Type::getVoidTy(_context), false);
+	auto function = llvm::Function::Create(function_type, llvm::Function::ExternalLinkage, jit_assignments_name, _module);
+	function->addFnAttr(llvm::Attribute::UWTable);
+
+	_builder.SetInsertPoint(llvm::BasicBlock::Create(_context, "entry", function));
+	_parameters.clear();
+
+	for (auto i = assignments.cbegin(); i != assignments.cend(); i++)
+		(*i)->accept(*this);
+
+	_builder.CreateRetVoid();
+}
+
+void jit_compiler::compile_function(const ast_function* function) {
+	auto compiled_function = _functions[function->name()];
+	compiled_function->addFnAttr(llvm::Attribute::UWTable);
+
+	_builder.SetInsertPoint(llvm::BasicBlock::Create(_context, "entry", compiled_function));
+	_parameters.clear();
+
+	auto argument = compiled_function->arg_begin();
+	for (auto i = function->parameters().cbegin(); i != function->parameters().cend(); i++, argument++) {
+		argument->setName(i->first);
+
+		_parameters[i->first] = operand{ argument, i->second };
+	}
+
+	if (_memoized_functions.find(function->name()) != _memoized_functions.end()) {
+		compile_memoized_function(function, compiled_function);
+
+		return;
+	}
+
+	tail_recursion recursion(function);
+	if (recursion.is_loop()) {
+		compile_loop(recursion, compiled_function);
+
+		return;
+	}
+
+	auto result = convert(compile(function->expression()), function->expression()->type());
+	_builder.CreateRet(result.value);
+}
+
+void jit_compiler::compile_memoized_function(const ast_function* function, llvm::Function* compiled_function) {
+	auto name = function->name();
+	auto result_type = type_of(function->expression()->type());
+	auto long_type = type_of(expression_type::Long);
+	auto pointer_type = llvm::Type::getInt8PtrTy(_context);
+	auto count = _builder.getInt64(compiled_function->arg_size());
+
+	auto table = new llvm::GlobalVariable(*_module, pointer_type, false, llvm::GlobalValue::ExternalLinkage,
+		llvm::Constant::getNullValue(pointer_type), name + ".memo");
+	_memo_table_symbols[name] = table->getName().str();
+
+	auto arguments = _builder.CreateAlloca(long_type, count, "arguments");
+	auto found = _builder.CreateAlloca(long_type, nullptr, "found");
+	auto argument = compiled_function->arg_begin();
+	for (unsigned i = 0; i < compiled_function->arg_size(); i++, argument++)
+		_builder.CreateStore(argument, _builder.CreateConstInBoundsGEP1_64(long_type, arguments, i));
+
+	auto find_block = llvm::BasicBlock::Create(_context, "memo.find", compiled_function);
+	auto miss_block = llvm::BasicBlock::Create(_context, "memo.miss", compiled_function);
+
+	// The dense arrays are indexed by the only argument, `filled` marks computed elements.
+	auto index = compiled_function->arg_begin();
+	auto values_type = llvm::ArrayType::get(result_type, memo_dense_size);
+	auto filled_type = llvm::ArrayType::get(_builder.getInt8Ty(), memo_dense_size);
+	llvm::Value* is_dense = nullptr;
+	llvm::GlobalVariable* values = nullptr;
+	llvm::GlobalVariable* filled = nullptr;
+	if (compiled_function->arg_size() == 1) {
+		values = new llvm::GlobalVariable(*_module, values_type, false, llvm::GlobalValue::InternalLinkage,
+			llvm::Constant::getNullValue(values_type), name + ".memo.values");
+		filled = new llvm::GlobalVariable(*_module, filled_type, false, llvm::GlobalValue::InternalLinkage,
+			llvm::Constant::getNullValue(filled_type), name + ".memo.filled");
+
+		auto dense_find_block = llvm::BasicBlock::Create(_context, "memo.dense.find", compiled_function);
+		is_dense = _builder.CreateICmpULT(index, _builder.getInt64(memo_dense_size));
+		_builder.CreateCondBr(is_dense, dense_find_block, find_block);
+
+		_builder.SetInsertPoint(dense_find_block);
+		auto value_pointer = _builder.CreateInBoundsGEP(values_type, values, { _builder.getInt64(0), index });
+		auto filled_pointer = _builder.CreateInBoundsGEP(filled_type, filled, { _builder.getInt64(0), index });
+
+		auto dense_hit_block = llvm::BasicBlock::Create(_context, "memo.dense.hit", compiled_function);
+		auto is_filled = _builder.CreateICmpNE(_builder.CreateLoad(_builder.getInt8Ty(), filled_pointer), _builder.getInt8(0));
+		_builder.CreateCondBr(is_filled, dense_hit_block, miss_block);
+
+		_builder.SetInsertPoint(dense_hit_block);
+		_builder.CreateRet(_builder.CreateLoad(result_type, value_pointer));
+	}
+	else
+		_builder.CreateBr(find_block);
+
+	_builder.SetInsertPoint(find_block);
+	auto hit_block = llvm::BasicBlock::Create(_context, "memo.hit", compiled_function);
+	auto is_found = _builder.CreateCall(get_memo_find_function(),
+		{ _builder.CreateLoad(pointer_type, table), arguments, count, found });
+	_builder.CreateCondBr(_builder.CreateICmpNE(is_found, _builder.getInt32(0)), hit_block, miss_block);
+
+	_builder.SetInsertPoint(hit_block);
+	_builder.CreateRet(_builder.CreateBitCast(_builder.CreateLoad(long_type, found), result_type));
+
+	_builder.SetInsertPoint(miss_block);
+	auto result = convert(compile(function->expression()), function->expression()->type()).value;
+	auto store_block = llvm::BasicBlock::Create(_context, "memo.store", compiled_function);
+
+	if (is_dense != nullptr) {
+		auto dense_store_block = llvm::BasicBlock::Create(_context, "memo.dense.store", compiled_function);
+		_builder.CreateCondBr(is_dense, dense_store_block, store_block);
+
+		_builder.SetInsertPoint(dense_store_block);
+		_builder.CreateStore(result, _builder.CreateInBoundsGEP(values_type, values, { _builder.getInt64(0), index }));
+		_builder.CreateStore(_builder.getInt8(1), _builder.CreateInBoundsGEP(filled_type, filled, { _builder.getInt64(0), index }));
+		_builder.CreateRet(result);
+	}
+	else
+		_builder.CreateBr(store_block);
+
+	_builder.SetInsertPoint(store_block);
+	_builder.CreateCall(get_memo_store_function(),
+		{ _builder.CreateLoad(pointer_type, table), arguments, count, _builder.CreateBitCast(result, long_type) });
+	_builder.CreateRet(result);
+}
+
+// Parameters become phi nodes of the loop block, tail self-calls branch back to it
+// with the arguments, and leaves of the body return.
+void jit_compiler::compile_loop(const tail_recursion& recursion, llvm::Function* compiled_function) {
+	auto entry_block = _builder.GetInsertBlock();
+	_loop_block = llvm::BasicBlock::Create(_context, "loop", compiled_function);
+	_builder.CreateBr(_loop_block);
+	_builder.SetInsertPoint(_loop_block);
+
+	_loop_parameters.clear();
+	auto argument = compiled_function->arg_begin();
+	auto parameters = recursion.function()->parameters();
+	for (auto i = parameters.cbegin(); i != parameters.cend(); i++, argument++) {
+		auto parameter = _builder.CreatePHI(type_of(i->second), 2, i->first);
+		parameter->addIncoming(argument, entry_block);
+
+		_parameters[i->first] = operand{ parameter, i->second };
+		_loop_parameters.push_back(parameter);
+	}
+
+	_accumulator = nullptr;
+	if (recursion.has_accumulator()) {
+		bool is_add = recursion.accumulator_operation() == binary_operation::Add;
+		_accumulator = _builder.CreatePHI(type_of(expression_type::Long), 2, "accumulator");
+		_accumulator->addIncoming(llvm::ConstantInt::get(type_of(expression_type::Long), is_add ? 0 : 1), entry_block);
+	}
+
+	std::vector<expression_type> types;
+	compile_tail(recursion, recursion.function()->expression(), types);
+}
+
+void jit_compiler::compile_tail(const tail_recursion& recursion, const ast_expression* expression, std::vector<expression_type>& types) {
+	auto result_type = recursion.function()->expression()->type();
+	bool is_exact = std::all_of(types.cbegin(), types.cend(), [result_type](expression_type type) { return type == result_type; });
+	auto tail = recursion.classify(expression, is_exact);
+	auto compiled_function = _builder.GetInsertBlock()->getParent();
+
+	if (tail.kind == tail_kind::Branch) {
+		auto condition = compile(tail.branch->logical_expression());
+		auto then_block = llvm::BasicBlock::Create(_context, "then", compiled_function);
+		auto else_block = llvm::BasicBlock::Create(_context, "else", compiled_function);
+		_builder.CreateCondBr(condition, then_block, else_block);
+
+		types.push_back(tail.branch->type());
+		_builder.SetInsertPoint(then_block);
+		compile_tail(recursion, tail.branch->then_expression(), types);
+		_builder.SetInsertPoint(else_block);
+		compile_tail(recursion, tail.branch->else_expression(), types);
+		types.pop_back();
+
+		return;
+	}
+
+	if (tail.kind == tail_kind::Value) {
+		auto result = compile(expression);
+		for (auto i = types.crbegin(); i != types.crend(); i++)
+			result = convert(result, *i);
+
+		result = convert(result, result_type);
+
+		if (_accumulator != nullptr)
+			result.value = accumulate(recursion.accumulator_operation(), _accumulator, result.value);
+
+		_builder.CreateRet(result.value);
+
+		return;
+	}
+
+	// The operand and the arguments are computed from the current parameters before any of them changes.
+	llvm::Value* accumulator = _accumulator;
+	if (tail.kind == tail_kind::Accumulate) {
+		auto value = convert(compile(tail.operand), expression_type::Long).value;
+		accumulator = accumulate(recursion.accumulator_operation(), _accumulator, value);
+	}
+
+	std::vector<llvm::Value*> arguments;
+	auto parameters = recursion.function()->parameters();
+	for (size_t i = 0; i < parameters.size(); i++)
+		arguments.push_back(convert(compile(tail.call->parameters()[i]), parameters[i].second).value);
+
+	auto block = _builder.GetInsertBlock();
+	for (size_t i = 0; i < arguments.size(); i++)
+		_loop_parameters[i]->addIncoming(arguments[i], block);
+
+	if (_accumulator != nullptr)
+		_accumulator->addIncoming(accumulator, block);
+
+	_builder.CreateBr(_loop_block);
+}
+
+llvm::Value* jit_compiler::accumulate(binary_operation operation, llvm::Value* accumulator, llvm::Value* value) {
+	if (operation == binary_operation::Multiply)
+		return _builder.CreateMul(accumulator, value);
+
+	return _builder.CreateAdd(accumulator, value);
+}
+
+llvm::Type* jit_compiler::type_of(expression_type type) {
+	if (type == expression_type::Double)
+		return llvm::Type::getDoubleTy(_context);
+
+	return llvm::Type::getInt64Ty(_context);
+}
+
+llvm::Function* jit_compiler::get_standard_function(const std::string& name, size_t parameter_count) {
+	auto double_type = llvm::Type::getDoubleTy(_context);
+	std::vector<llvm::Type*> parameter_types(parameter_count, double_type);
+	auto function_type = llvm::FunctionType::get(double_type, parameter_types, false);
+
+	return llvm::cast<llvm::Function>(_module->getOrInsertFunction(name, function_type).getCallee());
+}
+
+// Integer division by zero is reported as an exception, the same way the evaluators do,
+// instead of crashing the host process with a hardware trap.
+llvm::Function* jit_compiler::get_division_by_zero_function() {
+	auto function_type = llvm::FunctionType::get(llvm::Type::getVoidTy(_context), false);
+	auto function = llvm::cast<llvm::Function>(_module->getOrInsertFunction("comcalc.division_by_zero", function_type).getCallee());
+	function->setDoesNotReturn();
+
+	return function;
+}
+
+llvm::Function* jit_compiler::get_memo_find_function() {
+	auto long_pointer_type = llvm::Type::getInt64PtrTy(_context);
+	auto function_type = llvm::FunctionType::get(_builder.getInt32Ty(),
+		{ llvm::Type::getInt8PtrTy(_context), long_pointer_type, _builder.getInt64Ty(), long_pointer_type }, false);
+
+	return llvm::cast<llvm::Function>(_module->getOrInsertFunction(jit_memo_find_name, function_type).getCallee());
+}
+
+llvm::Function* jit_compiler::get_memo_store_function() {
+	auto function_type = llvm::FunctionType::get(llvm::Type::getVoidTy(_context),
+		{ llvm::Type::getInt8PtrTy(_context), llvm::Type::getInt64PtrTy(_context), _builder.getInt64Ty(), _builder.getInt64Ty() }, false);
+
+	return llvm::cast<llvm::Function>(_module->getOrInsertFunction(jit_memo_store_name, function_type).getCallee());
+}
+
+void jit_compiler::check_divisor(llvm::Value* divisor) {
+	auto function = _builder.GetInsertBlock()->getParent();
+	auto error_block = llvm::BasicBlock::Create(_context, "division.by.zero", function);
+	auto continue_block = llvm::BasicBlock::Create(_context, "division", function);
+
+	auto is_zero = _builder.CreateICmpEQ(divisor, llvm::ConstantInt::get(divisor->getType(), 0));
+	_builder.CreateCondBr(is_zero, error_block, continue_block);
+
+	_builder.SetInsertPoint(error_block);
+	_builder.CreateCall(get_division_by_zero_function());
+	_builder.CreateUnreachable();
+
+	_builder.SetInsertPoint(continue_block);
+}
+
+jit_compiler::operand jit_compiler::compile(const ast_expression* expression) {
+	expression->accept(*this);
+
+	auto result = _operands.top();
+	_operands.pop();
+
+	return result;
+}
+
+llvm::Value* jit_compiler::compile(const ast_logical_expression* logical_expression) {
+	logical_expression->accept(*this);
+
+	auto result = _conditions.top();
+	_conditions.pop();
+
+	return result;
+}
+
+jit_compiler::operand jit_compiler::convert(operand value, expression_type type) {
+	if (value.type == type)
+		return value;
+
+	if (type == expression_type::Double)
+		return operand{ _builder.CreateSIToFP(value.value, type_of(type)), type };
+
+	return operand{ _builder.CreateFPToSI(value.value, type_of(type)), type };
+}
+
+void jit_compiler::visit_assignment(const ast_assignment* assignment) {
+	auto result = convert(compile(assignment->expression()), _global_types[assignment->name()]);
+
+	_builder.CreateStore(result.value, _globals[assignment->name()]);
+}
+
+void jit_compiler::visit_long(const ast_long* _long) {
+	_operands.push(operand{ llvm::ConstantInt::get(type_of(expression_type::Long), _long->value(), true), expression_type::Long });
+}
+
+void jit_compiler::visit_double(const ast_double* _double) {
+	_operands.push(operand{ llvm::ConstantFP::get(type_of(expression_type::Double), _double->value()), expression_type::Double });
+}
+
+void jit_compiler::visit_variable(const ast_variable* variable) {
+	// A read of a parameter has a type of its own, the value is converted to it.
+	auto parameter = _parameters.find(variable->name());
+	if (parameter != _parameters.end()) {
+		_operands.push(convert(parameter->second, variable->type()));
+
+		return;
+	}
+
+	auto type = _global_types[variable->name()];
+	auto value = _builder.CreateLoad(type_of(type), _globals[variable->name()], variable->name());
+
+	_operands.push(operand{ value, type });
+}
+
+void jit_compiler::visit_call(const ast_call* call) {
+	auto unary_standard_function = find_unary_standard_function(call->name());
+	auto binary_standard_function = find_binary_standard_function(call->name());
+	bool is_standard_function = unary_standard_function != nullptr || binary_standard_function != nullptr;
+
+	llvm::Function* function;
+	if (is_standard_function)
+		function = get_standard_function(call->name(), call->parameters().size());
+	else {
+		auto user_function = _functions.find(call->name());
+		if (user_function == _functions.end())
+			throw new std::runtime_error("Function `" + call->name() + "` is not declared.");
+
+		function = user_function->second;
+	}
+
+	std::vector<llvm::Value*> arguments;
+	auto parameter = function->arg_begin();
+	for (auto i = call->parameters().cbegin(); i != call->parameters().cend(); i++, parameter++) {
+		auto type = parameter->getType()->isDoubleTy() ? expression_type::Double : expression_type::Long;
+
+		arguments.push_back(convert(compile(*i), type).value);
+	}
+
+	auto result_type = function->getReturnType()->isDoubleTy() ? expression_type::Double : expression_type::Long;
+
+	_operands.push(operand{ _builder.CreateCall(function, arguments), result_type });
+}
+
+void jit_compiler::visit_unary_operator(const ast_unary_operator* unary_operator) {
+	auto value = compile(unary_operator->operand());
+
+	if (unary_operator->operation() == unary_operation::Positive) {
+		_operands.push(value);
+
+		return;
+	}
+
+	if (value.type == expression_type::Double)
+		_operands.push(operand{ _builder.CreateFNeg(value.value), value.type });
+	else
+		_operands.push(operand{ _builder.CreateNeg(value.value), value.type });
+}
+
+void jit_compiler::visit_binary_operator(const ast_binary_operator* binary_operator) {
+	auto type = binary_operator->type();
+	auto left = convert(compile(binary_operator->left()), type).value;
+	auto right = convert(compile(binary_operator->right()), type).value;
+
+	llvm::Value* result = nullptr;
+	if (type == expression_type::Double) {
+		switch (binary_operator->operation()) {
+		case binary_operation::Add:
+			result = _builder.CreateFAdd(left, right);
+			break;
+		case binary_operation::Subtract:
+			result = _builder.CreateFSub(left, right);
+			break;
+		case binary_operation::Multiply:
+			result = _builder.CreateFMul(left, right);
+			break;
+		case binary_operation::Divide:
+			result = _builder.CreateFDiv(left, right);
+			break;
+		case binary_operation::Reminder:
+			result = _builder.CreateCall(get_standard_function(jit_fmod_name, 2), { left, right });
+			break;
+		case binary_operation::Pow:
+			result = _builder.CreateCall(get_standard_function(jit_pow_name, 2), { left, right });
+			break;
+		}
+	}
+	else {
+		switch (binary_operator->operation()) {
+		case binary_operation::Add:
+			result = _builder.CreateAdd(left, right);
+			break;
+		case binary_operation::Subtract:
+			result = _builder.CreateSub(left, right);
+			break;
+		case binary_operation::Multiply:
+			result = _builder.CreateMul(left, right);
+			break;
+		case binary_operation::Divide:
+			check_divisor(right);
+			result = _builder.CreateSDiv(left, right);
+			break;
+		case binary_operation::Reminder:
+			check_divisor(right);
+			result = _builder.CreateSRem(left, right);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (result == nullptr)
+		throw new std::runtime_error("Invalid binary operation.");
+
+	_operands.push(operand{ result, type });
+}
+
+void jit_compiler::visit_logical_binary_operator(const ast_logical_binary_operator* logical_binary_operator) {
+	auto function = _builder.GetInsertBlock()->getParent();
+	bool is_or = logical_binary_operator->operation() == "or";
+
+	auto left = compile(logical_binary_operator->left());
+	auto left_block = _builder.GetInsertBlock();
+	auto right_block = llvm::BasicBlock::Create(_context, is_or ? "or.right" : "and.right", function);
+	auto end_block = llvm::BasicBlock::Create(_context, is_or ? "or.end" : "and.end", function);
+
+	if (is_or)
+		_builder.CreateCondBr(left, end_block, right_block);
+	else
+		_builder.CreateCondBr(left, right_block, end_block);
+
+	_builder.SetInsertPoint(right_block);
+	auto right = compile(logical_binary_operator->right());
+	right_block = _builder.GetInsertBlock();
+	_builder.CreateBr(end_block);
+
+	_builder.SetInsertPoint(end_block);
+	auto result = _builder.CreatePHI(_builder.getInt1Ty(), 2);
+	result->addIncoming(_builder.getInt1(is_or), left_block);
+	result->addIncoming(right, right_block);
+
+	_conditions.push(result);
+}
+
+void jit_compiler::visit_logical_not_operator(const ast_logical_not_operator* logical_not_operator) {
+	_conditions.push(_builder.CreateNot(compile(logical_not_operator->operand())));
+}
+
+void jit_compiler::visit_condition(const ast_condition* condition) {
+	auto type = expression_type::Long;
+	if (condition->left()->type() == expression_type::Double || condition->right()->type() == expression_type::Double)
+		type = expression_type::Double;
+
+	auto left = convert(compile(condition->left()), type).value;
+	auto right = convert(compile(condition->right()), type).value;
+	auto operation = condition->operation();
+	bool is_double = type == expression_type::Double;
+
+	llvm::CmpInst::Predicate predicate;
+	if (operation == "<")
+		predicate = is_double ? llvm::CmpInst::FCMP_OLT : llvm::CmpInst::ICMP_SLT;
+	else if (operation == "<=")
+		predicate = is_double ? llvm::CmpInst::FCMP_OLE : llvm::CmpInst::ICMP_SLE;
+	else if (operation == ">")
+		predicate = is_double ? llvm::CmpInst::FCMP_OGT : llvm::CmpInst::ICMP_SGT;
+	else if (operation == ">=")
+		predicate = is_double ? llvm::CmpInst::FCMP_OGE : llvm::CmpInst::ICMP_SGE;
+	else if (operation == "=")
+		predicate = is_double ? llvm::CmpInst::FCMP_OEQ : llvm::CmpInst::ICMP_EQ;
+	else if (operation == "<>")
+		predicate = is_double ? llvm::CmpInst::FCMP_UNE : llvm::CmpInst::ICMP_NE;
+	else
+		throw new std::runtime_error("Invalid comparison operation `" + operation + "`.");
+
+	_conditions.push(_builder.CreateCmp(predicate, left, right));
+}
+
+void jit_compiler::visit_if_then_else(const ast_if_then_else* if_then_else) {
+	auto type = if_then_else->type();
+	auto function = _builder.GetInsertBlock()->getParent();
+
+	auto condition = compile(if_then_else->logical_expression());
+	auto then_block = llvm::BasicBlock::Create(_context, "then", function);
+	auto else_block = llvm::BasicBlock::Create(_context, "else", function);
+	auto end_block = llvm::BasicBlock::Create(_context, "end", function);
+	_builder.CreateCondBr(condition, then_block, else_block);
+
+	_builder.SetInsertPoint(then_block);
+	auto then_value = convert(compile(if_then_else->then_expression()), type).value;
+	then_block = _builder.GetInsertBlock();
+	_builder.CreateBr(end_block);
+
+	_builder.SetInsertPoint(else_block);
+	auto else_value = convert(compile(if_then_else->else_expression()), type).value;
+	else_block = _builder.GetInsertBlock();
+	_builder.CreateBr(end_block);
+
+	_builder.SetInsertPoint(end_block);
+	auto result = _builder.CreatePHI(type_of(type), 2);
+	result->addIncoming(then_value, then_block);
+	result->addIncoming(else_value, else_block);
+
+	_operands.push(operand{ result, type });
+}
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef __JIT_COMPILER_H__
+#define __JIT_COMPILER_H__
+
+#ifdef COMCALC_LLVM
+
+#include <map>
+#include <memory>
+#include <set>
+#include <stack>
+#include <string>
+#include <vector>
+
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+
+#include "ast.h"
+#include "table_registry.h"
+#include "tail_recursion.h"
+#include "value.h"
+
+// Name of the generated function executing all the assignments. It is not a valid
+// identifier of comcalc, so it never clashes with user functions.
+const char* const jit_assignments_name = "comcalc.assignments";
+
+// Runtime helpers accessing the memo_table of a memoized function.
+const char* const jit_memo_find_name = "comcalc.memo_find";
+
+const char* const jit_memo_store_name = "comcalc.memo_store";
+
+// Runtime helpers computing `^` and `%` of `double` by std::pow and std::fmod, like the
+// evaluators do. LLVM neither folds nor rewrites calls of them, so the results are the same
+// to the last bit and NaN has the same sign.
+const char* const jit_pow_name = "comcalc.pow";
+
+const char* const jit_fmod_name = "comcalc.fmod";
+
+// Builds the program in memory through the LLVM C++ API instead of printing textual IR.
+// Static variables become globals, user functions become functions of the same names
+// with `i64` or `double` parameters and results.
+class jit_compiler : private visitor
+{
+public:
+	// When `memoize` is set, functions found by find_memoizable_functions() check their
+	// memo tables before computing the body.
+	jit_compiler(llvm::LLVMContext& context, bool memoize = false);
+
+	std::unique_ptr<llvm::Module> compile(const table_registry& table_registry);
+
+	// Actual symbol names in the module, they differ from the program names only on clashes.
+	const std::map<std::string, std::string>& global_symbols() const { return _global_symbols; }
+
+	const std::map<std::string, std::string>& function_symbols() const { return _function_symbols; }
+
+	const std::map<std::string, expression_type>& global_types() const { return _global_types; }
+
+	// Globals of memoized functions to be set to their memo_table pointers before the first call.
+	const std::map<std::string, std::string>& memo_table_symbols() const { return _memo_table_symbols; }
+
+private:
+	struct operand
+	{
+		llvm::Value* value;
+		expression_type type;
+	};
+
+	llvm::LLVMContext& _context;
+	llvm::IRBuilder<> _builder;
+	llvm::Module* _module;
+	bool _memoize;
+	std::set<std::string> _memoized_functions;
+	std::map<std::string, expression_type> _global_types;
+	std::map<std::string, llvm::GlobalVariable*> _globals;
+	std::map<std::string, llvm::Function*> _functions;
+	std::map<std::string, std::string> _global_symbols;
+	std::map<std::string, std::string> _function_symbols;
+	std::map<std::string, std::string> _memo_table_symbols;
+	std::map<std::string, operand> _parameters;
+	std::stack<operand> _operands;
+	std::stack<llvm::Value*> _conditions;
+	llvm::BasicBlock* _loop_block;
+	std::vector<llvm::PHINode*> _loop_parameters;
+	llvm::PHINode* _accumulator;
+
+	void compile_assignments(const std::vector<const ast_assignment*>& assignments);
+
+	void compile_function(const ast_function* function);
+
+	void compile_memoized_function(const ast_function* function, llvm::Function* compiled_function);
+
+	void compile_loop(const tail_recursion& recursion, llvm::Function* compiled_function);
+
+	// `types` are types of the enclosing branches, the outermost first.
+	void compile_tail(const tail_recursion& recursion, const ast_expression* expression, std::vector<expression_type>& types);
+
+	llvm::Value* accumulate(binary_operation operation, llvm::Value* accumulator, llvm::Value* value);
+
+	llvm::Type* type_of(expression_type type);
+
+	llvm::Function* get_standard_function(const std::string& name, size_t parameter_count);
+
+	llvm::Function* get_division_by_zero_function();
+
+	llvm::Function* get_memo_find_function();
+
+	llvm::Function* get_memo_store_function();
+
+	void check_divisor(llvm::Value* divisor);
+
+	operand compile(const ast_expression* expression);
+
+	llvm::Value* compile(const ast_logical_expression* logical_expression);
+
+	operand convert(operand value, expression_type type);
+
+	virtual void visit_assignment(const ast_assignment* assignment);
+
+	virtual void visit_long(const ast_long* _long);
+
+	virtual void visit_double(const ast_double* _double);
+
+	virtual void visit_variable(const ast_variable* variable);
+
+	virtual void visit_call(const ast_call* call);
+
+	virtual void visit_unary_operator(const ast_unary_operator* unary_operator);
+
+	virtual void visit_binary_operator(const ast_binary_operator* binary_operator);
+
+	virtual void visit_logical_binary_operator(const ast_logical_binary_operator* logical_binary_operator);
+
+	virtual void visit_logical_not_operator(const ast_logical_not_operator* logical_not_operator);
+
+	virtual void visit_condition(const ast_condition* condition);
+
+	virtual void visit_if_then_else(const ast_if_then_else* if_then_else);
+};
+
+#endif
+
+#endif
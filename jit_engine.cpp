@@ -0,0 +1,267 @@
+#ifdef COMCALC_LLVM
+
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include "jit_compiler.h"
+#include "jit_engine.h"
+
+// Writes `address size name` lines in the format perf expects for JIT-compiled code.
+class perf_map_listener : public llvm::JITEventListener
+{
+private:
+	std::ofstream _out;
+	std::mutex _mutex;
+
+public:
+	perf_map_listener() {
+		_out.open("/tmp/perf-" + std::to_string(llvm::sys::Process::getProcessId()) + ".map", std::ios::app);
+	}
+
+	virtual void notifyObjectLoaded(ObjectKey, const llvm::object::ObjectFile& object,
+		const llvm::RuntimeDyld::LoadedObjectInfo& info) {
+		// The debug object has the section addresses where the code is actually loaded.
+		auto debug_object = info.getObjectForDebug(object);
+		const llvm::object::ObjectFile* loaded_object = debug_object.getBinary();
+		if (loaded_object == nullptr)
+			loaded_object = &object;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		auto symbols = llvm::object::computeSymbolSizes(*loaded_object);
+		for (auto i = symbols.cbegin(); i != symbols.cend(); i++) {
+			auto type = i->first.getType();
+			if (!type || *type != llvm::object::SymbolRef::ST_Function)
+				continue;
+
+			auto name = i->first.getName();
+			auto address = i->first.getAddress();
+			if (!name || !address) {
+				llvm::consumeError(name.takeError());
+				llvm::consumeError(address.takeError());
+
+				continue;
+			}
+
+			_out << std::hex << *address << " " << i->second << std::dec << " " << name->str() << std::endl;
+		}
+	}
+};
+
+static void division_by_zero() {
+	throw new std::runtime_error("Division by zero.");
+}
+
+static double power(double base, double exponent) {
+	return std::pow(base, exponent);
+}
+
+static double reminder(double dividend, double divisor) {
+	return std::fmod(dividend, divisor);
+}
+
+// Memo tables of functions are reached through these helpers when the argument
+// is out of the range of the dense table compiled into the function.
+static int32_t memo_find(memo_table* table, const int64_t* arguments, int64_t count, int64_t* result) {
+	return table->find(arguments, (size_t)count, result) ? 1 : 0;
+}
+
+static void memo_store(memo_table* table, const int64_t* arguments, int64_t count, int64_t result) {
+	table->store(arguments, (size_t)count, result);
+}
+
+static void initialize_native_target() {
+	static std::once_flag is_initialized;
+
+	std::call_once(is_initialized, []() {
+		llvm::InitializeNativeTarget();
+		llvm::InitializeNativeTargetAsmPrinter();
+	});
+}
+
+template<typename T>
+static T take_value(llvm::Expected<T> expected) {
+	if (!expected)
+		throw new std::runtime_error("JIT error: " + llvm::toString(expected.takeError()));
+
+	return std::move(*expected);
+}
+
+static void throw_if_error(llvm::Error error) {
+	if (error)
+		throw new std::runtime_error("JIT error: " + llvm::toString(std::move(error)));
+}
+
+static void optimize(llvm::Module& module) {
+	llvm::LoopAnalysisManager loop_analysis_manager;
+	llvm::FunctionAnalysisManager function_analysis_manager;
+	llvm::CGSCCAnalysisManager cgscc_analysis_manager;
+	llvm::ModuleAnalysisManager module_analysis_manager;
+	llvm::PassBuilder pass_builder;
+
+	pass_builder.registerModuleAnalyses(module_analysis_manager);
+	pass_builder.registerCGSCCAnalyses(cgscc_analysis_manager);
+	pass_builder.registerFunctionAnalyses(function_analysis_manager);
+	pass_builder.registerLoopAnalyses(loop_analysis_manager);
+	pass_builder.crossRegisterProxies(loop_analysis_manager, function_analysis_manager, cgscc_analysis_manager, module_analysis_manager);
+
+	auto pass_manager = pass_builder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2);
+	pass_manager.run(module, module_analysis_manager);
+}
+
+jit_engine::jit_engine(const table_registry& table_registry, const evaluation_options& options) {
+	initialize_native_target();
+
+	if (options.perf_map)
+		_perf_map_listener = std::make_unique<perf_map_listener>();
+
+	// RTDyld is used explicitly because JIT event listeners are attached to it.
+	auto listener = _perf_map_listener.get();
+	_jit = take_value(llvm::orc::LLJITBuilder()
+		.setObjectLinkingLayerCreator([listener](llvm::orc::ExecutionSession& session, const llvm::Triple&) {
+			auto layer = std::make_unique<llvm::orc::RTDyldObjectLinkingLayer>(session,
+				[]() { return std::make_unique<llvm::SectionMemoryManager>(); });
+
+			if (listener != nullptr)
+				layer->registerJITEventListener(*listener);
+
+			return layer;
+		})
+		.create());
+
+	auto& main_library = _jit->getMainJITDylib();
+	auto& session = _jit->getExecutionSession();
+	auto data_layout = _jit->getDataLayout();
+
+	// Standard functions, `^` and `%` are bound to the same implementations the evaluators use.
+	llvm::orc::MangleAndInterner mangle(session, data_layout);
+	llvm::orc::SymbolMap runtime_symbols;
+	runtime_symbols[mangle("comcalc.division_by_zero")] = llvm::JITEvaluatedSymbol(
+		llvm::pointerToJITTargetAddress(&division_by_zero), llvm::JITSymbolFlags::Exported);
+	runtime_symbols[mangle(jit_pow_name)] = llvm::JITEvaluatedSymbol(
+		llvm::pointerToJITTargetAddress(&power), llvm::JITSymbolFlags::Exported);
+	runtime_symbols[mangle(jit_fmod_name)] = llvm::JITEvaluatedSymbol(
+		llvm::pointerToJITTargetAddress(&reminder), llvm::JITSymbolFlags::Exported);
+	runtime_symbols[mangle(jit_memo_find_name)] = llvm::JITEvaluatedSymbol(
+		llvm::pointerToJITTargetAddress(&memo_find), llvm::JITSymbolFlags::Exported);
+	runtime_symbols[mangle(jit_memo_store_name)] = llvm::JITEvaluatedSymbol(
+		llvm::pointerToJITTargetAddress(&memo_store), llvm::JITSymbolFlags::Exported);
+
+	auto standard_functions = table_registry.standard_functions();
+	for (auto i = standard_functions.cbegin(); i != standard_functions.cend(); i++) {
+		void* address = (void*)find_unary_standard_function(*i);
+		if (address == nullptr)
+			address = (void*)find_binary_standard_function(*i);
+
+		runtime_symbols[mangle(*i)] = llvm::JITEvaluatedSymbol(
+			llvm::pointerToJITTargetAddress(address), llvm::JITSymbolFlags::Exported);
+	}
+
+	throw_if_error(main_library.define(llvm::orc::absoluteSymbols(runtime_symbols)));
+	main_library.addGenerator(take_value(
+		llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(data_layout.getGlobalPrefix())));
+
+	auto context = std::make_unique<llvm::LLVMContext>();
+	jit_compiler compiler(*context, options.memoize);
+	auto module = compiler.compile(table_registry);
+	module->setDataLayout(data_layout);
+	module->setTargetTriple(_jit->getTargetTriple().str());
+	optimize(*module);
+
+	auto global_symbols = compiler.global_symbols();
+	auto function_symbols = compiler.function_symbols();
+	auto memo_table_symbols = compiler.memo_table_symbols();
+	_global_types = compiler.global_types();
+
+	throw_if_error(_jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context))));
+
+	_assignments = (assignments_function)lookup(jit_assignments_name);
+
+	for (auto i = function_symbols.cbegin(); i != function_symbols.cend(); i++)
+		_functions[i->first] = lookup(i->second);
+
+	// Tables live as long as the engine, so results are reused by following evaluations.
+	for (auto i = memo_table_symbols.cbegin(); i != memo_table_symbols.cend(); i++) {
+		_memo_tables.push_back(std::make_unique<memo_table>());
+		*(memo_table**)lookup(i->second) = _memo_tables.back().get();
+	}
+
+	auto output_variables = table_registry.output_variables();
+	for (auto i = global_symbols.cbegin(); i != global_symbols.cend(); i++) {
+		_globals[i->first] = lookup(i->second);
+
+		if (output_variables.find(i->first) == output_variables.end())
+			_input_variables[i->first] = _global_types[i->first];
+		else if (table_registry.input_variables().find(i->first) == table_registry.input_variables().end())
+			_output_variables[i->first] = _global_types[i->first];
+	}
+}
+
+void* jit_engine::lookup(const std::string& symbol) {
+	auto address = take_value(_jit->lookup(symbol));
+
+	return llvm::jitTargetAddressToPointer<void*>(address.getAddress());
+}
+
+void* jit_engine::function(const std::string& name) const {
+	auto function = _functions.find(name);
+	if (function == _functions.end())
+		throw new std::runtime_error("Function `" + name + "` is not declared.");
+
+	return function->second;
+}
+
+void jit_engine::set_global(const std::string& name, value global) {
+	auto address = _globals.find(name);
+	if (address == _globals.end())
+		throw new std::runtime_error("Unknown variable `" + name + "`.");
+
+	if (_global_types[name] == expression_type::Double)
+		*(double*)address->second = global.as_double();
+	else
+		*(int64_t*)address->second = global.as_long();
+}
+
+value jit_engine::get_global(const std::string& name) const {
+	auto address = _globals.find(name);
+	if (address == _globals.end())
+		throw new std::runtime_error("Unknown variable `" + name + "`.");
+
+	if (_global_types.at(name) == expression_type::Double)
+		return value(*(double*)address->second);
+
+	return value((long)*(int64_t*)address->second);
+}
+
+std::map<std::string, value> jit_engine::evaluate(const std::map<std::string, value>& inputs) {
+	for (auto i = _global_types.cbegin(); i != _global_types.cend(); i++)
+		set_global(i->first, value());
+
+	for (auto i = _input_variables.cbegin(); i != _input_variables.cend(); i++) {
+		auto input = inputs.find(i->first);
+		if (input == inputs.end())
+			throw new std::runtime_error("Value of input variable `" + i->first + "` is not set.");
+
+		set_global(i->first, input->second);
+	}
+
+	_assignments();
+
+	std::map<std::string, value> outputs;
+	for (auto i = _output_variables.cbegin(); i != _output_variables.cend(); i++)
+		outputs[i->first] = get_global(i->first);
+
+	return outputs;
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef __JIT_ENGINE_H__
+#define __JIT_ENGINE_H__
+
+#ifdef COMCALC_LLVM
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+
+#include "evaluation_options.h"
+#include "memoization.h"
+#include "table_registry.h"
+#include "value.h"
+
+// Compiles the program to machine code inside the current process with ORC LLJIT,
+// so it is evaluated at native speed without temporary files or child processes.
+class jit_engine
+{
+public:
+	typedef void (*assignments_function)();
+
+	// Uses `perf_map` and `memoize` of the options, the engine is not consulted.
+	jit_engine(const table_registry& table_registry, const evaluation_options& options = evaluation_options());
+
+	// Executes all the assignments over the current values of globals.
+	assignments_function assignments() const { return _assignments; }
+
+	// Returns the address of the compiled user function. Its parameters and result are
+	// `int64_t` or `double` according to their types in the program.
+	void* function(const std::string& name) const;
+
+	void set_global(const std::string& name, value global);
+
+	value get_global(const std::string& name) const;
+
+	// Sets all the globals from inputs, executes the assignments and returns the values of output variables.
+	std::map<std::string, value> evaluate(const std::map<std::string, value>& inputs);
+
+	const std::map<std::string, expression_type>& input_variables() const { return _input_variables; }
+
+private:
+	std::unique_ptr<llvm::JITEventListener> _perf_map_listener;
+	std::unique_ptr<llvm::orc::LLJIT> _jit;
+	std::vector<std::unique_ptr<memo_table>> _memo_tables;
+	assignments_function _assignments;
+	std::map<std::string, void*> _functions;
+	std::map<std::string, void*> _globals;
+	std::map<std::string, expression_type> _global_types;
+	std::map<std::string, expression_type> _input_variables;
+	std::map<std::string, expression_type> _output_variables;
+
+	void* lookup(const std::string& symbol);
+};
+
+#endif
+
+#endif
@@ -0,0 +1,133 @@
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined WIN32 || defined _WIN32 || defined __CYGWIN__
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "large_stack.h"
+
+// Passes take a few hundred bytes of stack per level in optimized builds. Debug builds
+// take more, so there is a margin. The stack is only reserved, memory is taken as it is used.
+static const size_t stack_bytes_per_level = 2048;
+static const size_t base_stack_bytes = 16 * 1024 * 1024;
+
+size_t expression_depth(const ast_program* program) {
+	std::vector<std::pair<const ast_node*, size_t>> nodes;
+	for (auto i = program->functions().cbegin(); i != program->functions().cend(); i++)
+		nodes.push_back(std::make_pair((*i)->expression(), 1));
+	for (auto i = program->assignments().cbegin(); i != program->assignments().cend(); i++)
+		nodes.push_back(std::make_pair((*i)->expression(), 1));
+
+	size_t max_depth = 0;
+	while (!nodes.empty()) {
+		auto node = nodes.back().first;
+		auto depth = nodes.back().second;
+		nodes.pop_back();
+
+		if (depth > max_depth)
+			max_depth = depth;
+
+		if (auto binary_operator = dynamic_cast<const ast_binary_operator*>(node)) {
+			nodes.push_back(std::make_pair(binary_operator->left(), depth + 1));
+			nodes.push_back(std::make_pair(binary_operator->right(), depth + 1));
+		}
+		else if (auto unary_operator = dynamic_cast<const ast_unary_operator*>(node))
+			nodes.push_back(std::make_pair(unary_operator->operand(), depth + 1));
+		else if (auto call = dynamic_cast<const ast_call*>(node)) {
+			for (auto i = call->parameters().cbegin(); i != call->parameters().cend(); i++)
+				nodes.push_back(std::make_pair(*i, depth + 1));
+		}
+		else if (auto if_then_else = dynamic_cast<const ast_if_then_else*>(node)) {
+			nodes.push_back(std::make_pair(if_then_else->logical_expression(), depth + 1));
+			nodes.push_back(std::make_pair(if_then_else->then_expression(), depth + 1));
+			nodes.push_back(std::make_pair(if_then_else->else_expression(), depth + 1));
+		}
+		else if (auto logical_binary_operator = dynamic_cast<const ast_logical_binary_operator*>(node)) {
+			nodes.push_back(std::make_pair(logical_binary_operator->left(), depth + 1));
+			nodes.push_back(std::make_pair(logical_binary_operator->right(), depth + 1));
+		}
+		else if (auto logical_not_operator = dynamic_cast<const ast_logical_not_operator*>(node))
+			nodes.push_back(std::make_pair(logical_not_operator->operand(), depth + 1));
+		else if (auto condition = dynamic_cast<const ast_condition*>(node)) {
+			nodes.push_back(std::make_pair(condition->left(), depth + 1));
+			nodes.push_back(std::make_pair(condition->right(), depth + 1));
+		}
+	}
+
+	return max_depth;
+}
+
+struct stack_work
+{
+	const std::function<void()>* work;
+	std::exception_ptr exception;
+};
+
+static void run_work(stack_work* work) {
+	try {
+		(*work->work)();
+	}
+	catch (...) {
+		work->exception = std::current_exception();
+	}
+}
+
+#if defined WIN32 || defined _WIN32 || defined __CYGWIN__
+static DWORD WINAPI run_thread(LPVOID parameter) {
+	run_work(static_cast<stack_work*>(parameter));
+
+	return 0;
+}
+#else
+static void* run_thread(void* parameter) {
+	run_work(static_cast<stack_work*>(parameter));
+
+	return nullptr;
+}
+#endif
+
+void run_with_stack_for_depth(size_t depth, const std::function<void()>& work) {
+	if (depth <= shallow_expression_depth) {
+		work();
+
+		return;
+	}
+
+	size_t stack_size = base_stack_bytes + depth * stack_bytes_per_level;
+	stack_work thread_work{ &work, nullptr };
+
+#if defined WIN32 || defined _WIN32 || defined __CYGWIN__
+	HANDLE thread = CreateThread(nullptr, stack_size, run_thread, &thread_work, STACK_SIZE_PARAM_IS_A_RESERVATION, nullptr);
+	if (thread == nullptr)
+		throw new std::runtime_error("Can't start a thread with a stack for expressions "
+			+ std::to_string(depth) + " levels deep.");
+
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+#else
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+
+	pthread_t thread;
+	int result = pthread_attr_setstacksize(&attributes, stack_size);
+	if (result == 0)
+		result = pthread_create(&thread, &attributes, run_thread, &thread_work);
+
+	pthread_attr_destroy(&attributes);
+
+	if (result != 0)
+		throw new std::runtime_error("Can't start a thread with a stack for expressions "
+			+ std::to_string(depth) + " levels deep.");
+
+	pthread_join(thread, nullptr);
+#endif
+
+	if (thread_work.exception)
+		std::rethrow_exception(thread_work.exception);
+}
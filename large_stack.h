@@ -0,0 +1,24 @@
+#ifndef __LARGE_STACK_H__
+#define __LARGE_STACK_H__
+
+#include <cstddef>
+#include <functional>
+
+#include "ast.h"
+
+// Passes over the AST recurse once per level of an expression, so a long chain like a
+// sum of a million terms needs a stack far larger than threads get by default.
+
+// Up to this depth every pass fits into the default stack of any thread.
+const size_t shallow_expression_depth = 512;
+
+// Returns the deepest nesting of the expressions of the program. Walks the tree with an
+// explicit stack, so it works at any depth.
+size_t expression_depth(const ast_program* program);
+
+// Runs `work` on a thread with a stack large enough for expressions `depth` levels deep
+// and waits for it. Shallow work runs on the calling thread. An exception thrown by
+// `work` is rethrown on the calling thread.
+void run_with_stack_for_depth(size_t depth, const std::function<void()>& work);
+
+#endif
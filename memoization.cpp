@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <map>
+
+#include "memoization.h"
+#include "value.h"
+
+// Collects what the body of a function depends on besides its parameters.
+class function_dependencies : private visitor
+{
+private:
+	const std::vector<symbol_id>* _parameters;
+	bool _reads_variables;
+	std::set<std::string> _callees;
+
+	virtual void visit_variable(const ast_variable* variable) {
+		if (std::find(_parameters->cbegin(), _parameters->cend(), variable->symbol()) == _parameters->cend())
+			_reads_variables = true;
+	}
+
+	virtual void visit_call(const ast_call* call) {
+		bool is_standard_function = find_unary_standard_function(call->name()) != nullptr
+			|| find_binary_standard_function(call->name()) != nullptr;
+
+		if (!is_standard_function)
+			_callees.insert(call->name());
+
+		visitor::visit_call(call);
+	}
+
+public:
+	function_dependencies(const ast_function* function) : _parameters(&function->parameter_symbols()), _reads_variables(false) {
+		function->expression()->accept(*this);
+	}
+
+	bool reads_variables() const { return _reads_variables; }
+
+	const std::set<std::string>& callees() const { return _callees; }
+};
+
+static bool is_reachable(const std::string& from, const std::string& to,
+	const std::map<std::string, std::set<std::string>>& calls, std::set<std::string>& visited) {
+	auto callees = calls.find(from);
+	if (callees == calls.end())
+		return false;
+
+	for (auto i = callees->second.cbegin(); i != callees->second.cend(); i++) {
+		if (*i == to)
+			return true;
+
+		if (visited.insert(*i).second && is_reachable(*i, to, calls, visited))
+			return true;
+	}
+
+	return false;
+}
+
+std::set<std::string> find_memoizable_functions(const table_registry& table_registry) {
+	std::map<std::string, std::set<std::string>> calls;
+	std::set<std::string> pure_functions;
+
+	auto functions = table_registry.functions();
+	for (auto i = functions.cbegin(); i != functions.cend(); i++) {
+		function_dependencies dependencies(*i);
+
+		calls[(*i)->name()] = dependencies.callees();
+		if (!dependencies.reads_variables())
+			pure_functions.insert((*i)->name());
+	}
+
+	// A function calling an impure one is impure too.
+	bool is_changed = true;
+	while (is_changed) {
+		is_changed = false;
+
+		for (auto i = calls.cbegin(); i != calls.cend(); i++) {
+			if (pure_functions.find(i->first) == pure_functions.end())
+				continue;
+
+			for (auto j = i->second.cbegin(); j != i->second.cend(); j++) {
+				if (pure_functions.find(*j) == pure_functions.end()) {
+					pure_functions.erase(i->first);
+					is_changed = true;
+
+					break;
+				}
+			}
+		}
+	}
+
+	std::set<std::string> result;
+	for (auto i = functions.cbegin(); i != functions.cend(); i++) {
+		auto name = (*i)->name();
+		if (pure_functions.find(name) == pure_functions.end() || (*i)->parameters().empty())
+			continue;
+
+		bool is_long_only = true;
+		for (auto j = (*i)->parameters().cbegin(); j != (*i)->parameters().cend(); j++)
+			is_long_only = is_long_only && j->second == expression_type::Long;
+
+		std::set<std::string> visited;
+		if (is_long_only && is_reachable(name, name, calls, visited))
+			result.insert(name);
+	}
+
+	return result;
+}
+
+size_t memo_table::arguments_hash::operator()(const std::vector<int64_t>& arguments) const {
+	size_t hash = 0;
+	for (auto i = arguments.cbegin(); i != arguments.cend(); i++)
+		hash = hash * 31 + std::hash<int64_t>()(*i);
+
+	return hash;
+}
+
+bool memo_table::find(const int64_t* arguments, size_t count, int64_t* result) const {
+	auto found = _results.find(std::vector<int64_t>(arguments, arguments + count));
+	if (found == _results.end())
+		return false;
+
+	*result = found->second;
+
+	return true;
+}
+
+void memo_table::store(const int64_t* arguments, size_t count, int64_t result) {
+	_results[std::vector<int64_t>(arguments, arguments + count)] = result;
+}
@@ -0,0 +1,35 @@
+#ifndef __MEMOIZATION_H__
+#define __MEMOIZATION_H__
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "table_registry.h"
+
+// Returns names of user functions worth memoizing: recursive (directly or through other
+// functions), pure, i.e. depending on parameters only and calling pure functions only,
+// and having `long` parameters only, so the arguments are exact keys.
+std::set<std::string> find_memoizable_functions(const table_registry& table_registry);
+
+// Results of a memoized function by its arguments. Results are stored as 64-bit patterns,
+// so the table serves both `long` and `double` functions.
+class memo_table
+{
+private:
+	struct arguments_hash
+	{
+		size_t operator()(const std::vector<int64_t>& arguments) const;
+	};
+
+	std::unordered_map<std::vector<int64_t>, int64_t, arguments_hash> _results;
+
+public:
+	bool find(const int64_t* arguments, size_t count, int64_t* result) const;
+
+	void store(const int64_t* arguments, size_t count, int64_t result);
+};
+
+#endif
@@ -1,3 +1,5 @@
+#include <charconv>
+#include <cstring>
 #include <set>
 #include <stdexcept>
 #include <vector>
@@ -7,21 +9,24 @@
 const ast_program* parser::parse_program() {
     std::vector<const ast_function*> functions;
     std::vector<const ast_assignment*> assignments;
+    _arena.reset(new arena());
+    _symbols.reset(new symbol_table());
 
     do {
-        std::string name;
-        expect(lexeme::Identifier, &name);
-
+        symbol_id symbol;
+        expect(lexeme::Identifier, &symbol);
+        const std::string& name = _symbols->name(symbol);
 
 		if (skip(lexeme::LParen)) {
-			std::map<std::string, expression_type> parameters = parse_parameters();
+			std::vector<symbol_id> parameter_symbols;
+			std::vector<std::pair<std::string, expression_type>> parameters = parse_parameters(&parameter_symbols);
 
 			expect(lexeme::RParen);
 			expect(lexeme::Eq);
 
 			const ast_expression* expression = parse_expression();
 
-			ast_function* function = new ast_function(name, parameters, expression);
+			ast_function* function = _arena->create<ast_function>(symbol, name, parameters, parameter_symbols, expression);
 			functions.push_back(function);
 		}
         else {
@@ -29,7 +34,7 @@ const ast_program* parser::parse_program() {
 
             const ast_expression* expression = parse_expression();
 
-            ast_assignment* assignment = new ast_assignment(name, expression);
+            ast_assignment* assignment = _arena->create<ast_assignment>(symbol, name, expression);
 			assignments.push_back(assignment);
         }
 
@@ -38,7 +43,7 @@ const ast_program* parser::parse_program() {
         
     } while (scanner.lexeme() != lexeme::Eof);
 
-    return new ast_program(functions, assignments);
+    return new ast_program(_arena.release(), _symbols.release(), functions, assignments);
 }
 
 static expression_type get_type_by_first_letter(char first_letter) {
@@ -48,15 +53,17 @@ static expression_type get_type_by_first_letter(char first_letter) {
 	return expression_type::Long;
 }
 
-std::map<std::string, expression_type> parser::parse_parameters() {
-    std::map<std::string, expression_type> parameters;
+std::vector<std::pair<std::string, expression_type>> parser::parse_parameters(std::vector<symbol_id>* symbols) {
+    std::vector<std::pair<std::string, expression_type>> parameters;
+    std::set<symbol_id> unique_symbols;
 
     do {
-        std::string name;
+        symbol_id symbol;
 
-        expect(lexeme::Identifier, &name);
+        expect(lexeme::Identifier, &symbol);
+        const std::string& name = _symbols->name(symbol);
 
-		if (parameters.find(name) != parameters.end())
+		if (!unique_symbols.insert(symbol).second)
 			throw new std::runtime_error("Dublicate parameter `" + name + "`.");
 
 		expression_type type;
@@ -71,86 +78,157 @@ std::map<std::string, expression_type> parser::parse_parameters() {
 		else
 			type = get_type_by_first_letter(name[0]);
 
-        parameters[name] = type;
+        parameters.push_back(std::make_pair(name, type));
+        symbols->push_back(symbol);
     } while (skip(lexeme::Comma));
 
     return parameters;
 }
 
+// Precedences of pending operators. Parentheses are below every operator, so operators
+// are never applied across them.
+static const int parenthesis_precedence = 0;
+static const int additive_precedence = 1;
+static const int multiplicative_precedence = 2;
+static const int pow_precedence = 3;
+static const int unary_precedence = 4;
+
+static const int or_precedence = 1;
+static const int and_precedence = 2;
+static const int not_precedence = 3;
+
 const ast_expression* parser::parse_expression() {
-    const ast_expression* left = parse_operand1();
+	size_t operators_start = _operators.size();
+	size_t open_parentheses = 0;
 
-    return parse_separated_operands1(left);
-}
+	while (true) {
+		// An operand is an optional sign followed by a parenthesized expression or by a
+		// variable, constant, call or `if`.
+		if (skip(lexeme::Minus))
+			_operators.push_back(pending_operator{ unary_precedence, binary_operation::Add, unary_operation::Negative });
+		else if (skip(lexeme::Plus))
+			_operators.push_back(pending_operator{ unary_precedence, binary_operation::Add, unary_operation::Positive });
 
-const ast_expression* parser::parse_separated_operands1(const ast_expression* left) {
-    binary_operation operation;
-    if (skip(lexeme::Plus))
-        operation = binary_operation::Add;
-    else if (skip(lexeme::Minus))
-        operation = binary_operation::Subtract;
-    else
-        return left;
+		if (skip(lexeme::LParen)) {
+			_operators.push_back(pending_operator{ parenthesis_precedence, binary_operation::Add, unary_operation::Positive });
+			open_parentheses++;
+
+			continue;
+		}
 
-    const ast_expression* right = parse_operand1();
-    ast_expression* binary_operator = new ast_binary_operator(operation, left, right);
+		_operands.push_back(parse_operand());
 
-    return parse_separated_operands1(binary_operator);
-}
+		binary_operation operation;
+		int precedence;
+
+		while (true) {
+			if (_operators.size() > operators_start && _operators.back().precedence == unary_precedence)
+				apply_operator();
+
+			precedence = skip_binary_operator(&operation);
+			if (precedence != parenthesis_precedence)
+				break;
+
+			while (_operators.size() > operators_start && _operators.back().precedence != parenthesis_precedence)
+				apply_operator();
+
+			if (open_parentheses == 0) {
+				const ast_expression* expression = _operands.back();
+				_operands.pop_back();
+
+				return expression;
+			}
+
+			expect(lexeme::RParen);
 
-const ast_expression* parser::parse_operand1() {
-    const ast_expression* left = parse_operand2();
+			_operators.pop_back();
+			open_parentheses--;
+		}
+
+		// `^` is right associative, the other operators are left associative.
+		while (_operators.size() > operators_start && (_operators.back().precedence > precedence
+			|| (_operators.back().precedence == precedence && precedence != pow_precedence)))
+			apply_operator();
 
-    return parse_separated_operands2(left);
+		_operators.push_back(pending_operator{ precedence, operation, unary_operation::Positive });
+	}
 }
 
-const ast_expression* parser::parse_separated_operands2(const ast_expression* left) {
-	binary_operation operation;
-	if (skip(lexeme::Star))
-        operation = binary_operation::Multiply;
-    else if (skip(lexeme::Slash))
-        operation = binary_operation::Divide;
-    else if (skip(lexeme::Percent))
-        operation = binary_operation::Reminder;
-    else
-        return left;
-
-    const ast_expression* right = parse_operand2();
-    ast_expression* binary_operator = new ast_binary_operator(operation, left, right);
-
-    return parse_separated_operands2(binary_operator);
+// Returns the precedence of the binary operator skipped, or parenthesis_precedence if
+// the lexeme is not a binary operator.
+int parser::skip_binary_operator(binary_operation* operation) {
+	switch (scanner.lexeme()) {
+	case lexeme::Plus:
+		*operation = binary_operation::Add;
+		break;
+	case lexeme::Minus:
+		*operation = binary_operation::Subtract;
+		break;
+	case lexeme::Star:
+		*operation = binary_operation::Multiply;
+		break;
+	case lexeme::Slash:
+		*operation = binary_operation::Divide;
+		break;
+	case lexeme::Percent:
+		*operation = binary_operation::Reminder;
+		break;
+	case lexeme::Caret:
+		*operation = binary_operation::Pow;
+		break;
+	default:
+		return parenthesis_precedence;
+	}
+
+	scanner.next();
+
+	if (*operation == binary_operation::Add || *operation == binary_operation::Subtract)
+		return additive_precedence;
+
+	if (*operation == binary_operation::Pow)
+		return pow_precedence;
+
+	return multiplicative_precedence;
 }
 
-const ast_expression* parser::parse_operand2() {
-    const ast_expression* left = parse_operand3();
+// Replaces the top operands with the top operator applied to them.
+void parser::apply_operator() {
+	pending_operator pending = _operators.back();
+	_operators.pop_back();
 
-    while (skip(lexeme::Caret)) {
-        const ast_expression* right = parse_operand2();
+	const ast_expression* right = _operands.back();
+	_operands.pop_back();
 
-        left = new ast_binary_operator(binary_operation::Pow, left, right);
-    }
+	if (pending.precedence == unary_precedence) {
+		_operands.push_back(_arena->create<ast_unary_operator>(pending.unary, right));
+
+		return;
+	}
 
-    return left;
+	_operands.back() = _arena->create<ast_binary_operator>(pending.binary, _operands.back(), right);
 }
 
-const ast_expression* parser::parse_operand3() {
-    if (skip(lexeme::Minus))
-        return new ast_unary_operator(unary_operation::Negative, parse_operand4());
+template<typename T>
+static T parse_constant(std::string_view text) {
+    T value;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size())
+        throw new std::runtime_error("Invalid constant `" + std::string(text) + "`.");
 
-    if (skip(lexeme::Plus))
-        return new ast_unary_operator(unary_operation::Positive, parse_operand4());
-    
-    return parse_operand4();
+    return value;
 }
 
-const ast_expression* parser::parse_operand4() {
-    std::string token;
-    if (skip(lexeme::Identifier, &token)) {
+const ast_expression* parser::parse_operand() {
+    symbol_id symbol;
+    std::string_view constant;
+    if (skip(lexeme::Identifier, &symbol)) {
+        const std::string& token = _symbols->name(symbol);
+
         if (skip(lexeme::LParen)) {
 			std::vector<const ast_expression*> parameters;
 
 			if (skip(lexeme::RParen))
-				return new ast_call(token, parameters);
+				return _arena->create<ast_call>(symbol, token, parameters);
 
 			do {
 				auto expression = parse_expression();
@@ -159,33 +237,33 @@ const ast_expression* parser::parse_operand4() {
 
             expect(lexeme::RParen);
 
-            return new ast_call(token, parameters);
+            return _arena->create<ast_call>(symbol, token, parameters);
         }
 		else if (skip(lexeme::Colon)) {
 			if (skip(lexeme::Long))
-				return new ast_variable(token, expression_type::Long);
+				return _arena->create<ast_variable>(symbol, token, expression_type::Long);
 
 			if (skip(lexeme::Double))
-				return new ast_variable(token, expression_type::Double);
+				return _arena->create<ast_variable>(symbol, token, expression_type::Double);
 
 			throw new std::runtime_error("Unknown type. Must be 'long' or 'double'.");
 		}
 
 		bool is_long_variable_by_default = std::strchr("ijklmnIJKLMN", token[0]) != NULL;
 		if (is_long_variable_by_default)
-			return new ast_variable(token, expression_type::Long);
+			return _arena->create<ast_variable>(symbol, token, expression_type::Long);
 
-		return new ast_variable(token, expression_type::Double);
+		return _arena->create<ast_variable>(symbol, token, expression_type::Double);
     }
-    else if (skip(lexeme::LongConstant, &token)) {
-        int value = std::stoi(token);
+    else if (skip(lexeme::LongConstant, &constant)) {
+        long value = parse_constant<long>(constant);
 
-        return new ast_long(value);
+        return _arena->create<ast_long>(value);
     }
-    else if (skip(lexeme::DoubleConstant, &token)) {
-        double value = std::stod(token);
+    else if (skip(lexeme::DoubleConstant, &constant)) {
+        double value = parse_constant<double>(constant);
         
-        return new ast_double(value);
+        return _arena->create<ast_double>(value);
     }
     else if (skip(lexeme::If)) {
 		const ast_logical_expression* logical_expression = parse_logical_expression();
@@ -198,72 +276,85 @@ const ast_expression* parser::parse_operand4() {
 
 		const ast_expression* else_expression = parse_expression();
 
-		return new ast_if_then_else(logical_expression, then_expression, else_expression);
-    }
-    else if (skip(lexeme::LParen)) {
-        const ast_expression* expression = parse_expression();
-		expect(lexeme::RParen);
-
-		return expression;
+		return _arena->create<ast_if_then_else>(logical_expression, then_expression, else_expression);
     }
     
     throw new std::runtime_error("Operand expected.");
 }
 
 const ast_logical_expression* parser::parse_logical_expression() {
-	const ast_logical_expression* left = parse_logical_operand1();
+	size_t operators_start = _logical_operators.size();
+	size_t open_parentheses = 0;
 
-	return parse_separated_logical_operands1(left);
-}
+	while (true) {
+		if (skip(lexeme::Not))
+			_logical_operators.push_back(pending_logical_operator{ not_precedence, "not" });
 
-const ast_logical_expression* parser::parse_logical_operand1() {
-	const ast_logical_expression* left = parse_logical_operand2();
+		if (skip(lexeme::LParen)) {
+			_logical_operators.push_back(pending_logical_operator{ parenthesis_precedence, nullptr });
+			open_parentheses++;
 
-	return parse_separated_logical_operands2(left);
-}
+			continue;
+		}
 
-const ast_logical_expression* parser::parse_separated_logical_operands1(const ast_logical_expression* left) {
-	if (skip(lexeme::Or)) {
-		const ast_logical_expression* right = parse_logical_operand1();
-		ast_logical_expression* binary_operator = new ast_logical_binary_operator("or", left, right);
+		_logical_operands.push_back(parse_condition());
 
-		return parse_separated_logical_operands1(binary_operator);
-	}
+		pending_logical_operator pending;
 
-	return left;
-}
+		while (true) {
+			if (_logical_operators.size() > operators_start && _logical_operators.back().precedence == not_precedence)
+				apply_logical_operator();
 
-const ast_logical_expression* parser::parse_logical_operand2() {
-	if (skip(lexeme::Not)) {
-		const ast_logical_expression* operand = parse_logical_operand3();
+			if (skip(lexeme::Or)) {
+				pending = pending_logical_operator{ or_precedence, "or" };
+				break;
+			}
 
-		return new ast_logical_not_operator(operand);
-	}
+			if (skip(lexeme::And)) {
+				pending = pending_logical_operator{ and_precedence, "and" };
+				break;
+			}
 
-	return parse_logical_operand3();
-}
+			while (_logical_operators.size() > operators_start
+				&& _logical_operators.back().precedence != parenthesis_precedence)
+				apply_logical_operator();
 
-const ast_logical_expression* parser::parse_separated_logical_operands2(const ast_logical_expression* left) {
-	if (skip(lexeme::And)) {
-		const ast_logical_expression* right = parse_logical_operand1();
-		ast_logical_expression* binary_operator = new ast_logical_binary_operator("and", left, right);
+			if (open_parentheses == 0) {
+				const ast_logical_expression* logical_expression = _logical_operands.back();
+				_logical_operands.pop_back();
 
-		return parse_separated_logical_operands2(binary_operator);
-	}
+				return logical_expression;
+			}
+
+			expect(lexeme::RParen);
+
+			_logical_operators.pop_back();
+			open_parentheses--;
+		}
+
+		// `or` is left associative and `and` is right associative.
+		while (_logical_operators.size() > operators_start && (_logical_operators.back().precedence > pending.precedence
+			|| (_logical_operators.back().precedence == pending.precedence && pending.precedence == or_precedence)))
+			apply_logical_operator();
 
-	return left;
+		_logical_operators.push_back(pending);
+	}
 }
 
-const ast_logical_expression* parser::parse_logical_operand3() {
-	if (skip(lexeme::LParen)) {
-		const ast_logical_expression* logical_expression = parse_logical_expression();
+void parser::apply_logical_operator() {
+	pending_logical_operator pending = _logical_operators.back();
+	_logical_operators.pop_back();
 
-		expect(lexeme::RParen);
+	const ast_logical_expression* right = _logical_operands.back();
+	_logical_operands.pop_back();
 
-		return logical_expression;
+	if (pending.precedence == not_precedence) {
+		_logical_operands.push_back(_arena->create<ast_logical_not_operator>(right));
+
+		return;
 	}
 
-	return parse_condition();
+	_logical_operands.back() = _arena->create<ast_logical_binary_operator>(pending.operation, _logical_operands.back(), right);
 }
 
 const ast_logical_expression* parser::parse_condition() {
@@ -287,7 +378,7 @@ const ast_logical_expression* parser::parse_condition() {
 
 	const ast_expression* right = parse_expression();
 
-	return new ast_condition(operation, left, right);
+	return _arena->create<ast_condition>(operation, left, right);
 }
 
 void throw_if_unexpected_lexeme(lexeme expected_lexeme, lexeme actual_lexeme) {
@@ -302,10 +393,10 @@ void parser::expect(lexeme lexeme) {
 	scanner.next();
 }
 
-void parser::expect(lexeme lexeme, std::string* buffer) {
+void parser::expect(lexeme lexeme, symbol_id* symbol) {
 	throw_if_unexpected_lexeme(lexeme, scanner.lexeme());
 
-	*buffer = scanner.buffer();
+	*symbol = _symbols->intern(scanner.buffer());
 
 	scanner.next();
 }
@@ -320,9 +411,9 @@ bool parser::skip(lexeme lexeme) {
 	return false;
 }
 
-bool parser::skip(lexeme lexeme, std::string* buffer) {
+bool parser::skip(lexeme lexeme, symbol_id* symbol) {
 	if (scanner.lexeme() == lexeme) {
-		*buffer = scanner.buffer();
+		*symbol = _symbols->intern(scanner.buffer());
 
 		scanner.next();
 
@@ -332,3 +423,14 @@ bool parser::skip(lexeme lexeme, std::string* buffer) {
 	return false;
 }
 
+bool parser::skip(lexeme lexeme, std::string_view* buffer) {
+	if (scanner.lexeme() == lexeme) {
+		*buffer = scanner.buffer();
+
+		scanner.next();
+
+		return true;
+	}
+
+	return false;
+}
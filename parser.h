@@ -3,60 +3,78 @@
 
 #include <istream>
 #include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "ast.h"
 #include "scanner.h"
 
+// An operator waiting for its right operand, or an open parenthesis, of the expression
+// being parsed. Unary and `not` operators take the operand that follows them only.
+struct pending_operator
+{
+	int precedence;
+	binary_operation binary;
+	unary_operation unary;
+};
+
+struct pending_logical_operator
+{
+	int precedence;
+	const char* operation;
+};
+
 class parser
 {
 private:
-    scanner scanner;
+    ::scanner scanner;
+    std::unique_ptr<arena> _arena;
+    std::unique_ptr<symbol_table> _symbols;
+
+	// Expressions are parsed with explicit stacks, so neither long nor deeply parenthesized
+	// expressions take stack space. Nested calls, e.g. of arguments, use the tops of the stacks.
+	std::vector<const ast_expression*> _operands;
+	std::vector<pending_operator> _operators;
+	std::vector<const ast_logical_expression*> _logical_operands;
+	std::vector<pending_logical_operator> _logical_operators;
 
 public:
     parser(std::istream& in): scanner(in) {
     }
 
+    parser(std::string_view text): scanner(text) {
+    }
+
     const ast_program* parse_program();
 
 protected:
-	std::map<std::string, expression_type> parse_parameters();
+	std::vector<std::pair<std::string, expression_type>> parse_parameters(std::vector<symbol_id>* symbols);
 
 	const ast_expression* parse_expression();
 
-	const ast_expression* parse_operand1();
+	const ast_expression* parse_operand();
 
-	const ast_expression* parse_separated_operands1(const ast_expression* left);
+	int skip_binary_operator(binary_operation* operation);
 
-	const ast_expression* parse_operand2();
-
-	const ast_expression* parse_separated_operands2(const ast_expression* left);
-
-	const ast_expression* parse_operand3();
-
-	const ast_expression* parse_operand4();
+	void apply_operator();
 
 	const ast_logical_expression* parse_logical_expression();
 
-	const ast_logical_expression* parse_logical_operand1();
-
-	const ast_logical_expression* parse_separated_logical_operands1(const ast_logical_expression* left);
-
-	const ast_logical_expression* parse_logical_operand2();
-
-	const ast_logical_expression* parse_separated_logical_operands2(const ast_logical_expression* left);
-
-	const ast_logical_expression* parse_logical_operand3();
+	void apply_logical_operator();
 
 	const ast_logical_expression* parse_condition();
 	
 	void expect(lexeme lexeme);
 
-    void expect(lexeme lexeme, std::string* buffer);
+    void expect(lexeme lexeme, symbol_id* symbol);
 
     bool skip(lexeme lexeme);
 
-    bool skip(lexeme lexeme, std::string* buffer);
+    bool skip(lexeme lexeme, symbol_id* symbol);
+
+    bool skip(lexeme lexeme, std::string_view* buffer);
 };
 
 #endif
\ No newline at end of file
@@ -1,176 +1,240 @@
-#include <cctype>
 #include <stdexcept>
 
 #include "scanner.h"
 
-std::map<lexeme, const char*> scanner::_names =
+// Names of the lexemes for error messages, in the order of the enumeration.
+constexpr const char* lexeme_names[] =
 {
-	{ lexeme::NewLine, "'\\n'" },
-	{ lexeme::LParen, "'('" },
-	{ lexeme::RParen, "')'" },
-	{ lexeme::Eq, "'='" },
-	{ lexeme::Comma, "','" },
-	{ lexeme::Plus, "'+'" },
-	{ lexeme::Minus, "'-'" },
-	{ lexeme::Star, "'*'" },
-	{ lexeme::Slash, "'/'" },
-	{ lexeme::Percent, "'%'" },
-	{ lexeme::Caret, "'^'" },
-    { lexeme::Colon, ":" },
-	{ lexeme::If, "'if'" },
-	{ lexeme::Then, "'then'" },
-	{ lexeme::Else, "'else'" },
-	{ lexeme::Or, "'or'" },
-	{ lexeme::And, "'and'" },
-	{ lexeme::Not, "'not'" },
-	{ lexeme::Lt, "'<'" },
-	{ lexeme::Gt, "'>'" },
-	{ lexeme::Le, "'<='" },
-	{ lexeme::Ge, "'>='" },
-	{ lexeme::Ne, "'<>'" },
-	{ lexeme::Identifier, "identifier" },
-	{ lexeme::LongConstant, "long" },
-	{ lexeme::DoubleConstant, "double" },
-	{ lexeme::Eof, "end of file" },
+	"'\\n'",
+	"'('",
+	"')'",
+	"'='",
+	"','",
+	"'+'",
+	"'-'",
+	"'*'",
+	"'/'",
+	"'%'",
+	"'^'",
+	":",
+	"'if'",
+	"'then'",
+	"'else'",
+	"'or'",
+	"'and'",
+	"'not'",
+	"'long'",
+	"'double'",
+	"'<'",
+	"'>'",
+	"'<='",
+	"'>='",
+	"'<>'",
+	"identifier",
+	"long",
+	"double",
+	"end of file",
 };
 
+static_assert(sizeof(lexeme_names) / sizeof(lexeme_names[0]) == (size_t)lexeme::Eof + 1, "Every lexeme needs a name.");
+
+std::string scanner::name(::lexeme lexeme) {
+	return lexeme_names[(size_t)lexeme];
+}
+
+struct keyword
+{
+    std::string_view text;
+    ::lexeme value;
+};
+
+constexpr keyword keywords[] =
+{
+    { "if", lexeme::If },
+    { "then", lexeme::Then },
+    { "else", lexeme::Else },
+    { "or", lexeme::Or },
+    { "and", lexeme::And },
+    { "not", lexeme::Not },
+    { "long", lexeme::Long },
+    { "double", lexeme::Double },
+};
+
+const size_t keyword_table_size = 16;
+
+// Perfect hash of the keywords: no two of them have the same first letter, last letter
+// and length sum modulo 16. Any other word is recognized with a single comparison.
+constexpr size_t keyword_hash(std::string_view word) {
+    return ((unsigned char)word.front() + (unsigned char)word.back() + word.length()) % keyword_table_size;
+}
+
+struct keyword_table
+{
+    keyword slots[keyword_table_size];
+    bool is_perfect;
+};
+
+constexpr keyword_table build_keyword_table() {
+    keyword_table table{ {}, true };
+    for (size_t i = 0; i < keyword_table_size; i++)
+        table.slots[i] = keyword{ std::string_view(), lexeme::Identifier };
+
+    for (const auto& keyword : keywords) {
+        auto& slot = table.slots[keyword_hash(keyword.text)];
+        if (!slot.text.empty())
+            table.is_perfect = false;
+
+        slot = keyword;
+    }
+
+    return table;
+}
+
+constexpr keyword_table keyword_slots = build_keyword_table();
+
+static_assert(keyword_slots.is_perfect, "Keyword hash has collisions.");
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool is_alpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+const size_t read_block_size = 1 << 20;
+
+scanner::scanner(std::istream& input) {
+    while (input) {
+        size_t length = _text.size();
+        _text.resize(length + read_block_size);
+        input.read(&_text[length], read_block_size);
+        _text.resize(length + (size_t)input.gcount());
+    }
+
+    _position = _text.data();
+    _end = _position + _text.size();
+
+    next();
+}
+
+scanner::scanner(std::string_view text) {
+    _position = text.data();
+    _end = _position + text.size();
+
+    next();
+}
+
 lexeme scanner::read_lexeme() {
-    _buffer.clear();
+    while (_position != _end && *_position == ' ')
+        _position++;
+
+    const char* start = _position;
+    _buffer = std::string_view();
 
-    while (skip(' '))
-        ;
+    if (_position == _end)
+        return lexeme::Eof;
 
-    if (skip('\n')) {
-        while(skip('\n'))
-            ;
+    char c = *_position++;
+    switch (c) {
+    case '\n':
+        while (_position != _end && *_position == '\n')
+            _position++;
 
         return lexeme::NewLine;
-    }
 
-    if (take('('))
+    case '(':
         return lexeme::LParen;
 
-    if (take(')'))
+    case ')':
         return lexeme::RParen;
-  
-    if (take(','))
+
+    case ',':
         return lexeme::Comma;
 
-    if (take('+'))
+    case '+':
         return lexeme::Plus;
 
-    if (take('-'))
+    case '-':
         return lexeme::Minus;
 
-    if (take('*'))
+    case '*':
         return lexeme::Star;
 
-    if (take('/'))
+    case '/':
         return lexeme::Slash;
 
-    if (take('%'))
+    case '%':
         return lexeme::Percent;
 
-    if (take('^'))
+    case '^':
         return lexeme::Caret;
 
-    if (take(':'))
+    case ':':
         return lexeme::Colon;
 
-    if (take('='))
+    case '=':
         return lexeme::Eq;
 
-    if (take('>')) {
+    case '>':
         if (take('='))
             return lexeme::Ge;
 
         return lexeme::Gt;
-    }
 
-    if (take('<')) {
+    case '<':
         if (take('='))
             return lexeme::Le;
-            
+
         if (take('>'))
             return lexeme::Ne;
 
         return lexeme::Lt;
     }
 
-    if (take(std::isalpha)) {
-        while (take(std::isalnum))
-            ;
-
-        if (_buffer == "if")
-            return lexeme::If;
-        
-        if (_buffer == "then")
-            return lexeme::Then;
-        
-        if (_buffer == "else")
-            return lexeme::Else;
+    if (is_alpha(c))
+        return read_word(start);
 
-        if (_buffer == "or")
-            return lexeme::Or;
+    if (is_digit(c))
+        return read_number(start);
 
-        if (_buffer == "and")
-            return lexeme::And;
+    throw new std::runtime_error("Unknown token '" + std::string(1, c) + "'.");
+}
 
-        if (_buffer == "not")
-            return lexeme::Not;
+lexeme scanner::read_word(const char* start) {
+    while (_position != _end && (is_alpha(*_position) || is_digit(*_position)))
+        _position++;
 
-        if (_buffer == "long")
-            return lexeme::Long;
+    _buffer = std::string_view(start, _position - start);
 
-        if (_buffer == "double")
-            return lexeme::Double;
+    const keyword& slot = keyword_slots.slots[keyword_hash(_buffer)];
+    if (slot.text == _buffer)
+        return slot.value;
 
-        return lexeme::Identifier;
-    }
+    return lexeme::Identifier;
+}
 
-    if (take(std::isdigit)) {
-        while (take(std::isdigit))
-            ;
+lexeme scanner::read_number(const char* start) {
+    while (_position != _end && is_digit(*_position))
+        _position++;
 
-        if (take('.')) {
-            while (take(std::isdigit))
-                ;
+    if (take('.')) {
+        while (_position != _end && is_digit(*_position))
+            _position++;
 
-            return lexeme::DoubleConstant;            
-        }
+        _buffer = std::string_view(start, _position - start);
 
-        return lexeme::LongConstant;
+        return lexeme::DoubleConstant;
     }
 
-    if (_input.peek() == std::char_traits<char>::eof())
-        return lexeme::Eof;
-
-    throw new std::runtime_error("Unknown token '" + _buffer + "'.");
-}
-
-bool scanner::skip(char c) {
-    if (_input.peek() == c) {
-        _input.get();
+    _buffer = std::string_view(start, _position - start);
 
-        return true;
-    }
-
-    return false;
+    return lexeme::LongConstant;
 }
 
 bool scanner::take(char c) {
-    if (_input.peek() == c) {
-        _buffer += _input.get();
-
-        return true;
-    }
-
-    return false;
-}
-
-bool scanner::take(int (*function)(int)) {
-    if (function(_input.peek())) {
-        _buffer += _input.get();
+    if (_position != _end && *_position == c) {
+        _position++;
 
         return true;
     }
@@ -3,7 +3,7 @@
 
 #include <istream>
 #include <string>
-#include <map>
+#include <string_view>
 
 enum class lexeme
 {
@@ -38,26 +38,34 @@ enum class lexeme
     Eof,
 };
 
+// The scanner works over a single buffer holding the whole source. Lexemes are views
+// into that buffer, so they are valid while the scanner is alive and are never copied.
 class scanner
 {
 private:
-	static std::map<::lexeme, const char*> _names;
+    ::lexeme _lexeme;
+    std::string_view _buffer;
 
-    lexeme _lexeme;
-    std::string _buffer;
-
-    std::istream &_input;
+    std::string _text;
+    const char* _position;
+    const char* _end;
 
 public:
-    scanner(std::istream& input): _input(input) {
-        next();
-    }
+    // Reads the whole stream in large blocks.
+    scanner(std::istream& input);
+
+    // Scans the text without copying it, the text must outlive the scanner.
+    scanner(std::string_view text);
+
+    scanner(const scanner&) = delete;
+
+    scanner& operator=(const scanner&) = delete;
 
     ::lexeme lexeme() const {
         return _lexeme;
     }
 
-    const std::string &buffer() const {
+    std::string_view buffer() const {
         return _buffer;
     }
 
@@ -65,18 +73,16 @@ public:
         _lexeme = read_lexeme();
     }
 
-	static std::string name(::lexeme lexeme) {
-		return _names[lexeme];
-	}
+	static std::string name(::lexeme lexeme);
 
 protected:
     ::lexeme read_lexeme();
 
-    bool skip(char c);
+    ::lexeme read_word(const char* start);
 
-    bool take(char c);
+    ::lexeme read_number(const char* start);
 
-    bool take(int (*function)(int));
+    bool take(char c);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,27 +1,97 @@
 #include <stdexcept>
+#include <string_view>
 
 #include "step1_tables_builder.h"
 
+struct standard_function
+{
+	std::string_view name;
+	function_signature signature;
+};
+
+constexpr standard_function standard_functions[] =
+{
+	{ "acos", function_signature(expression_type::Double, expression_type::Double) },
+	{ "asin", function_signature(expression_type::Double, expression_type::Double) },
+	{ "atan", function_signature(expression_type::Double, expression_type::Double) },
+	{ "atan2", function_signature(expression_type::Double, expression_type::Double, expression_type::Double) },
+	{ "cos", function_signature(expression_type::Double, expression_type::Double) },
+	{ "exp", function_signature(expression_type::Double, expression_type::Double) },
+	{ "fabs", function_signature(expression_type::Double, expression_type::Double) },
+	{ "log", function_signature(expression_type::Double, expression_type::Double) },
+	{ "log10", function_signature(expression_type::Double, expression_type::Double) },
+	{ "sin", function_signature(expression_type::Double, expression_type::Double) },
+	{ "sqrt", function_signature(expression_type::Double, expression_type::Double) },
+	{ "tan", function_signature(expression_type::Double, expression_type::Double) },
+};
+
 table_registry step1_tables_builder::build(const ast_program* program) {
-	_input_variables.clear();
-	_output_variables.clear();
-	_standard_functions.clear();
+	_symbols = &program->symbols();
+	size_t symbol_count = _symbols->size();
+
+	_is_parameter.assign(symbol_count, false);
+	_input_types.assign(symbol_count, no_type);
+	_output_types.assign(symbol_count, no_type);
+	_is_standard_function_used.assign(symbol_count, false);
 	_functions.clear();
 	_assignments.clear();
+	_declared_functions.assign(symbol_count, nullptr);
+	_function_types.assign(symbol_count, no_type);
+
+	// Every name is looked up among standard functions once, not once per call.
+	_standard_signatures.assign(symbol_count, nullptr);
+	for (symbol_id i = 0; i < (symbol_id)symbol_count; i++) {
+		for (const auto& standard_function : standard_functions) {
+			if (standard_function.name == _symbols->name(i))
+				_standard_signatures[i] = &standard_function.signature;
+		}
+	}
 
 	program->accept(*this);
 
-	return table_registry(_input_variables, _output_variables, _standard_functions, _functions, _assignments);
+	// A variable is read with the type of its name or annotation. All the engines and the
+	// generator take that type, so an assignment of another type is rejected here.
+	for (symbol_id i = 0; i < (symbol_id)symbol_count; i++) {
+		if (_input_types[i] != no_type && _output_types[i] != no_type && _input_types[i] != _output_types[i])
+			throw new std::runtime_error("Incompatible type of variable `" + _symbols->name(i) + "`.");
+	}
+
+	std::set<std::string> used_standard_functions;
+	for (symbol_id i = 0; i < (symbol_id)symbol_count; i++) {
+		if (_is_standard_function_used[i])
+			used_standard_functions.insert(_symbols->name(i));
+	}
+
+	return table_registry(_symbols, _input_types, _output_types, used_standard_functions, _functions, _assignments);
 }
 
 void step1_tables_builder::visit_function(const ast_function* function) {
-	_parameters.clear();
-	auto first_parameter = function->parameters().cbegin();
-	auto last_parameter = function->parameters().cend();
-	_parameters.insert(first_parameter, last_parameter);
+	auto name = function->name();
+	auto symbol = function->symbol();
+
+	bool is_function_already_declared = _declared_functions[symbol] != nullptr;
+	if (is_function_already_declared)
+		throw new std::runtime_error("Function `" + name + "` already declared.");
+
+	_declared_functions[symbol] = function;
 
+	auto parameter_symbols = function->parameter_symbols();
+	for (auto i = parameter_symbols.cbegin(); i != parameter_symbols.cend(); i++)
+		_is_parameter[*i] = true;
+
+	// Recursive calls are typed as `long` first. If the body turns out to be `double`,
+	// they are typed once again, so the type can't change any more.
+	_function_types[symbol] = expression_type::Long;
 	visitor::visit_function(function);
 
+	if (function->expression()->type() == expression_type::Double) {
+		_function_types[symbol] = expression_type::Double;
+		visitor::visit_function(function);
+	}
+
+	for (auto i = parameter_symbols.cbegin(); i != parameter_symbols.cend(); i++)
+		_is_parameter[*i] = false;
+
 	_functions.push_back(function);
 }
 
@@ -29,46 +99,67 @@ void step1_tables_builder::visit_assignment(const ast_assignment* assignment) {
 	visitor::visit_assignment(assignment);
 	auto name = assignment->name();
 
-	bool is_identifier_already_declared = _output_variables.find(name) != _output_variables.end();
+	bool is_identifier_already_declared = _output_types[assignment->symbol()] != no_type;
 	if (is_identifier_already_declared)
 		throw new std::runtime_error("Variable `" + name + "` already declared.");
 
 	auto type = assignment->expression()->type();
 
-	_output_variables[name] = type;
+	_output_types[assignment->symbol()] = type;
 
 	_assignments.push_back(assignment);
 }
 
 void step1_tables_builder::visit_variable(const ast_variable* variable) {
-	_input_variables[variable->name()] = variable->type();;
+	bool is_parameter = _is_parameter[variable->symbol()];
+	if (!is_parameter)
+		_input_types[variable->symbol()] = variable->type();
 
 	visitor::visit_variable(variable);
 }
 
-static std::map<std::string, function_signature> standard_functions =
-{
-	{ "acos", function_signature(expression_type::Double, expression_type::Double) },
-	{ "asin", function_signature(expression_type::Double, expression_type::Double) },
-	{ "atan", function_signature(expression_type::Double, expression_type::Double) },
-	{ "atan2", function_signature(expression_type::Double, expression_type::Double, expression_type::Double) },
-	{ "cos", function_signature(expression_type::Double, expression_type::Double) },
-	{ "exp", function_signature(expression_type::Double, expression_type::Double) },
-	{ "fabs", function_signature(expression_type::Double, expression_type::Double) },
-	{ "log", function_signature(expression_type::Double, expression_type::Double) },
-	{ "log10", function_signature(expression_type::Double, expression_type::Double) },
-	{ "sin", function_signature(expression_type::Double, expression_type::Double) },
-	{ "sqrt", function_signature(expression_type::Double, expression_type::Double) },
-	{ "tan", function_signature(expression_type::Double, expression_type::Double) },
-};
-
 void step1_tables_builder::visit_call(const ast_call* call) {
 	auto function_name = call->name();
-	bool is_standard_function = standard_functions.find(call->name()) != standard_functions.end();
+	auto symbol = call->symbol();
+	auto standard_signature = _standard_signatures[symbol];
 	
-	if (is_standard_function) {
-		_standard_functions.insert(call->name());
+	if (standard_signature != nullptr) {
+		if (standard_signature->parameter_count() != call->parameters().size())
+			throw new std::runtime_error("Wrong number of parameters of function `" + function_name + "`.");
+
+		_is_standard_function_used[symbol] = true;
+		call->set_type(standard_signature->result_type());
+	}
+	else {
+		auto function = _declared_functions[symbol];
+		if (function == nullptr)
+			throw new std::runtime_error("Function `" + function_name + "` is not declared.");
+
+		if (function->parameters().size() != call->parameters().size())
+			throw new std::runtime_error("Wrong number of parameters of function `" + function_name + "`.");
+
+		call->set_type(_function_types[symbol]);
 	}
 
 	visitor::visit_call(call);
 }
+
+// Operators are typed when they are created, before the calls among their operands are.
+// They are visited after their operands, so their types are updated bottom up once.
+void step1_tables_builder::visit_unary_operator(const ast_unary_operator* unary_operator) {
+	visitor::visit_unary_operator(unary_operator);
+
+	unary_operator->update_type();
+}
+
+void step1_tables_builder::visit_binary_operator(const ast_binary_operator* binary_operator) {
+	visitor::visit_binary_operator(binary_operator);
+
+	binary_operator->update_type();
+}
+
+void step1_tables_builder::visit_if_then_else(const ast_if_then_else* if_then_else) {
+	visitor::visit_if_then_else(if_then_else);
+
+	if_then_else->update_type();
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef __STEP1_TABLES_BUILDER_H__
 #define __STEP1_TABLES_BUILDER_H__
 
+#include <cstddef>
 #include <map>
 #include <set>
 #include <string>
@@ -9,31 +10,29 @@
 #include "ast.h"
 #include "table_registry.h"
 
+// Literal type, so tables of signatures are built at compile time.
 class function_signature
 {
 private:
 	expression_type _result;
-	std::vector<expression_type> _parameters;
+	expression_type _parameters[2];
+	size_t _parameter_count;
 
 public:
-	expression_type result_type() const { return _result; }
+	constexpr expression_type result_type() const { return _result; }
 
-	const std::vector<expression_type> parameters() const { return _parameters; }
+	constexpr size_t parameter_count() const { return _parameter_count; }
 
-	function_signature(expression_type result) {
-		_result = result;
-	}
+	constexpr expression_type parameter_type(size_t index) const { return _parameters[index]; }
 
-	function_signature(expression_type parameter1, expression_type result) {
-		_result = result;
-		_parameters.push_back(parameter1);
-	}
+	constexpr function_signature(expression_type result)
+		: _result(result), _parameters{}, _parameter_count(0) { }
 
-	function_signature(expression_type parameter1, expression_type parameter2, expression_type result) {
-		_result = result;
-		_parameters.push_back(parameter1);
-		_parameters.push_back(parameter2);
-	}
+	constexpr function_signature(expression_type parameter1, expression_type result)
+		: _result(result), _parameters{ parameter1 }, _parameter_count(1) { }
+
+	constexpr function_signature(expression_type parameter1, expression_type parameter2, expression_type result)
+		: _result(result), _parameters{ parameter1, parameter2 }, _parameter_count(2) { }
 };
 
 class step1_tables_builder : private visitor
@@ -42,12 +41,17 @@ public:
 	table_registry build(const ast_program* program);
 
 private:
-	std::map<std::string, expression_type> _parameters;
-	std::map<std::string, expression_type> _input_variables;
-	std::map<std::string, expression_type> _output_variables;
-	std::set<std::string> _standard_functions;
+	// Tables are indexed by symbol ids of the program.
+	const symbol_table* _symbols;
+	std::vector<bool> _is_parameter;
+	std::vector<expression_type> _input_types;
+	std::vector<expression_type> _output_types;
+	std::vector<const function_signature*> _standard_signatures;
+	std::vector<bool> _is_standard_function_used;
 	std::vector<const ast_function*> _functions;
 	std::vector<const ast_assignment*> _assignments;
+	std::vector<const ast_function*> _declared_functions;
+	std::vector<expression_type> _function_types;
 
 	virtual void visit_function(const ast_function* function);
 
@@ -56,6 +60,12 @@ private:
 	virtual void visit_variable(const ast_variable* variable);
 
 	virtual void visit_call(const ast_call* call);
+
+	virtual void visit_unary_operator(const ast_unary_operator* unary_operator);
+
+	virtual void visit_binary_operator(const ast_binary_operator* binary_operator);
+
+	virtual void visit_if_then_else(const ast_if_then_else* if_then_else);
 };
 
 #endif
\ No newline at end of file
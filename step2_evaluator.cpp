@@ -0,0 +1,335 @@
+#include <stdexcept>
+
+#include "step2_evaluator.h"
+
+step2_evaluator::step2_evaluator(const table_registry& table_registry, size_t thread_count)
+	: _symbols(&table_registry.symbols()), _is_evaluated(false), _variables(std::make_shared<std::map<std::string, value>>()) {
+	auto input_variables = table_registry.input_variables();
+	auto output_variables = table_registry.output_variables();
+
+	for (auto i = input_variables.cbegin(); i != input_variables.cend(); i++) {
+		if (output_variables.find(i->first) == output_variables.end())
+			_input_only_variables.insert(*i);
+
+		_all_variables.insert(*i);
+	}
+
+	for (auto i = output_variables.cbegin(); i != output_variables.cend(); i++) {
+		if (input_variables.find(i->first) == input_variables.end())
+			_output_only_variables.insert(*i);
+
+		_all_variables.insert(*i);
+	}
+
+	for (auto i = table_registry.functions().cbegin(); i != table_registry.functions().cend(); i++)
+		_functions[(*i)->name()] = *i;
+
+	_assignments = table_registry.assignments();
+	_graph = std::make_unique<dependency_graph>(table_registry);
+
+	for (size_t i = 0; i < _assignments.size(); i++) {
+		if (!_graph->input_readers(_assignments[i]->symbol()).empty())
+			_forward_read_assignments.push_back(i);
+	}
+
+	if (thread_count > 1) {
+		_pool = std::make_unique<thread_pool>(thread_count);
+
+		for (size_t i = 1; i < thread_count; i++)
+			_workers.push_back(std::unique_ptr<step2_evaluator>(new step2_evaluator(this)));
+	}
+}
+
+step2_evaluator::step2_evaluator(const step2_evaluator* owner)
+	: _functions(owner->_functions), _symbols(owner->_symbols), _is_evaluated(false), _variables(owner->_variables) {
+}
+
+std::map<std::string, value> step2_evaluator::evaluate(const std::map<std::string, value>& inputs) {
+	auto& variables = *_variables;
+	variables.clear();
+	_is_evaluated = false;
+
+	// All the variables exist before the assignments, so parallel assignments never
+	// change the structure of the map.
+	for (auto i = _all_variables.cbegin(); i != _all_variables.cend(); i++)
+		variables[i->first] = value().cast_to(i->second);
+
+	for (auto i = _input_only_variables.cbegin(); i != _input_only_variables.cend(); i++) {
+		auto input = inputs.find(i->first);
+		if (input == inputs.end())
+			throw new std::runtime_error("Value of input variable `" + i->first + "` is not set.");
+
+		variables[i->first] = input->second.cast_to(i->second);
+	}
+
+	if (_pool == nullptr) {
+		for (auto i = _assignments.cbegin(); i != _assignments.cend(); i++)
+			(*i)->accept(*this);
+	}
+	else {
+		auto& levels = _graph->levels();
+		for (auto i = levels.cbegin(); i != levels.cend(); i++)
+			execute_level(*i);
+	}
+
+	_is_evaluated = true;
+
+	return outputs();
+}
+
+std::map<std::string, value> step2_evaluator::update(const std::map<std::string, value>& changed_inputs) {
+	if (!_is_evaluated)
+		throw new std::runtime_error("Inputs are not evaluated yet.");
+
+	auto& variables = *_variables;
+	std::vector<bool> is_dirty(_assignments.size(), false);
+
+	// Values overwritten by the update, restored in the reverse order when it fails.
+	std::vector<std::pair<std::map<std::string, value>::iterator, value>> overwritten_values;
+
+	try {
+		for (auto i = changed_inputs.cbegin(); i != changed_inputs.cend(); i++) {
+			auto input = _input_only_variables.find(i->first);
+			if (input == _input_only_variables.end())
+				throw new std::runtime_error("Unknown input variable `" + i->first + "`.");
+
+			auto input_value = i->second.cast_to(input->second);
+			auto variable = variables.find(i->first);
+			if (input_value.is_identical(variable->second))
+				continue;
+
+			overwritten_values.emplace_back(variable, variable->second);
+			variable->second = input_value;
+
+			auto readers = _graph->input_readers(_symbols->find(i->first));
+			for (auto j = readers.cbegin(); j != readers.cend(); j++)
+				is_dirty[*j] = true;
+		}
+
+		// Reads preceding the assignment of a variable see its initial value, like in evaluate().
+		// The assigned value is put back when the pass reaches a clean assignment.
+		std::vector<value> assigned_values;
+		for (auto i = _forward_read_assignments.cbegin(); i != _forward_read_assignments.cend(); i++) {
+			auto variable = variables.find(_assignments[*i]->name());
+
+			assigned_values.push_back(variable->second);
+			overwritten_values.emplace_back(variable, variable->second);
+			variable->second = value().cast_to(_all_variables.at(variable->first));
+		}
+
+		// Dependencies always precede their dependants, so one pass in the source order is enough.
+		std::map<std::string, value> changed_outputs;
+		size_t forward_read = 0;
+		for (size_t i = 0; i < _assignments.size(); i++) {
+			bool is_forward_read = forward_read < _forward_read_assignments.size() && _forward_read_assignments[forward_read] == i;
+			if (!is_dirty[i] && !is_forward_read)
+				continue;
+
+			auto assignment = _assignments[i];
+			auto variable = variables.find(assignment->name());
+			auto last_value = is_forward_read ? assigned_values[forward_read++] : variable->second;
+
+			if (!is_dirty[i]) {
+				variable->second = last_value;
+
+				continue;
+			}
+
+			overwritten_values.emplace_back(variable, variable->second);
+			assignment->accept(*this);
+
+			if (variable->second.is_identical(last_value))
+				continue;
+
+			auto& successors = _graph->successors(i);
+			for (auto j = successors.cbegin(); j != successors.cend(); j++)
+				is_dirty[*j] = true;
+
+			if (_output_only_variables.find(assignment->name()) != _output_only_variables.end())
+				changed_outputs[assignment->name()] = variable->second;
+		}
+
+		return changed_outputs;
+	}
+	catch (...) {
+		for (auto i = overwritten_values.rbegin(); i != overwritten_values.rend(); i++)
+			i->first->second = i->second;
+
+		// The failed assignment may have stopped inside a call or in the middle of an expression.
+		_parameters.clear();
+		_values = std::stack<value>();
+		_conditions = std::stack<bool>();
+
+		throw;
+	}
+}
+
+std::map<std::string, value> step2_evaluator::outputs() const {
+	std::map<std::string, value> outputs;
+	for (auto i = _output_only_variables.cbegin(); i != _output_only_variables.cend(); i++)
+		outputs[i->first] = _variables->at(i->first);
+
+	return outputs;
+}
+
+void step2_evaluator::execute_level(const std::vector<const ast_assignment*>& level) {
+	if (level.size() == 1) {
+		level.front()->accept(*this);
+
+		return;
+	}
+
+	_pool->run(level.size(), [this, &level](size_t thread, size_t index) {
+		step2_evaluator& evaluator = thread == 0 ? *this : *_workers[thread - 1];
+
+		level[index]->accept(evaluator);
+	});
+}
+
+value step2_evaluator::pop_value() {
+	auto result = _values.top();
+	_values.pop();
+
+	return result;
+}
+
+bool step2_evaluator::pop_condition() {
+	auto result = _conditions.top();
+	_conditions.pop();
+
+	return result;
+}
+
+value step2_evaluator::call_function(const ast_function* function, const std::vector<value>& arguments) {
+	std::map<std::string, value> parameters;
+	for (size_t i = 0; i < arguments.size(); i++) {
+		auto parameter = function->parameters()[i];
+
+		parameters[parameter.first] = arguments[i].cast_to(parameter.second);
+	}
+
+	std::swap(parameters, _parameters);
+	function->expression()->accept(*this);
+	std::swap(parameters, _parameters);
+
+	return pop_value().cast_to(function->expression()->type());
+}
+
+void step2_evaluator::visit_assignment(const ast_assignment* assignment) {
+	visitor::visit_assignment(assignment);
+
+	// Workers share the map, so they only look variables up and write through the
+	// element found. Every variable is in the map before the assignments run.
+	auto variable = _variables->find(assignment->name());
+	if (variable == _variables->end())
+		throw new std::runtime_error("Unknown variable `" + assignment->name() + "`.");
+
+	variable->second = pop_value();
+}
+
+void step2_evaluator::visit_long(const ast_long* _long) {
+	_values.push(value(_long->value()));
+}
+
+void step2_evaluator::visit_double(const ast_double* _double) {
+	_values.push(value(_double->value()));
+}
+
+void step2_evaluator::visit_variable(const ast_variable* variable) {
+	// A read of a parameter has a type of its own, the value is converted to it.
+	auto parameter = _parameters.find(variable->name());
+	if (parameter != _parameters.end()) {
+		_values.push(parameter->second.cast_to(variable->type()));
+
+		return;
+	}
+
+	auto stored = _variables->find(variable->name());
+	if (stored == _variables->end())
+		throw new std::runtime_error("Unknown variable `" + variable->name() + "`.");
+
+	_values.push(stored->second);
+}
+
+void step2_evaluator::visit_call(const ast_call* call) {
+	visitor::visit_call(call);
+
+	std::vector<value> arguments(call->parameters().size());
+	for (size_t i = arguments.size(); i > 0; i--)
+		arguments[i - 1] = pop_value();
+
+	auto unary_function = find_unary_standard_function(call->name());
+	if (unary_function != nullptr) {
+		_values.push(value(unary_function(arguments[0].as_double())));
+
+		return;
+	}
+
+	auto binary_function = find_binary_standard_function(call->name());
+	if (binary_function != nullptr) {
+		_values.push(value(binary_function(arguments[0].as_double(), arguments[1].as_double())));
+
+		return;
+	}
+
+	auto function = _functions.find(call->name());
+	if (function == _functions.end())
+		throw new std::runtime_error("Function `" + call->name() + "` is not declared.");
+
+	_values.push(call_function(function->second, arguments));
+}
+
+void step2_evaluator::visit_unary_operator(const ast_unary_operator* unary_operator) {
+	visitor::visit_unary_operator(unary_operator);
+
+	_values.push(calculate(unary_operator->operation(), pop_value()));
+}
+
+void step2_evaluator::visit_binary_operator(const ast_binary_operator* binary_operator) {
+	visitor::visit_binary_operator(binary_operator);
+
+	auto right = pop_value();
+	auto left = pop_value();
+
+	_values.push(calculate(binary_operator->operation(), left, right));
+}
+
+void step2_evaluator::visit_logical_binary_operator(const ast_logical_binary_operator* logical_binary_operator) {
+	logical_binary_operator->left()->accept(*this);
+	bool left = pop_condition();
+
+	bool is_short_circuit = logical_binary_operator->operation() == "or" ? left : !left;
+	if (is_short_circuit) {
+		_conditions.push(left);
+
+		return;
+	}
+
+	logical_binary_operator->right()->accept(*this);
+}
+
+void step2_evaluator::visit_logical_not_operator(const ast_logical_not_operator* logical_not_operator) {
+	visitor::visit_logical_not_operator(logical_not_operator);
+
+	_conditions.push(!pop_condition());
+}
+
+void step2_evaluator::visit_condition(const ast_condition* condition) {
+	visitor::visit_condition(condition);
+
+	auto right = pop_value();
+	auto left = pop_value();
+
+	_conditions.push(compare(condition->operation(), left, right));
+}
+
+void step2_evaluator::visit_if_then_else(const ast_if_then_else* if_then_else) {
+	if_then_else->logical_expression()->accept(*this);
+
+	if (pop_condition())
+		if_then_else->then_expression()->accept(*this);
+	else
+		if_then_else->else_expression()->accept(*this);
+
+	_values.push(pop_value().cast_to(if_then_else->type()));
+}
@@ -0,0 +1,89 @@
+#ifndef __STEP2_EVALUATOR_H__
+#define __STEP2_EVALUATOR_H__
+
+#include <map>
+#include <memory>
+#include <stack>
+#include <string>
+#include <vector>
+
+#include "ast.h"
+#include "dependency_graph.h"
+#include "table_registry.h"
+#include "thread_pool.h"
+#include "value.h"
+
+class step2_evaluator : private visitor
+{
+public:
+	// With more than one thread, independent assignments of every level of the
+	// dependency_graph are executed at once.
+	step2_evaluator(const table_registry& table_registry, size_t thread_count = 1);
+
+	// Executes all the assignments and returns the values of output variables.
+	std::map<std::string, value> evaluate(const std::map<std::string, value>& inputs);
+
+	// Sets the changed inputs and executes only the assignments depending on them, keeping
+	// the values of the rest from the last evaluation. An assignment whose value stays the
+	// same doesn't make its dependants recomputed. Returns the output variables that changed.
+	// When an assignment fails, all the variables get back the values they had before.
+	std::map<std::string, value> update(const std::map<std::string, value>& changed_inputs);
+
+	// Values of output variables after the last evaluation or update.
+	std::map<std::string, value> outputs() const;
+
+	const std::map<std::string, expression_type>& input_variables() const { return _input_only_variables; }
+
+private:
+	std::map<std::string, expression_type> _input_only_variables;
+	std::map<std::string, expression_type> _output_only_variables;
+	std::map<std::string, expression_type> _all_variables;
+	std::map<std::string, const ast_function*> _functions;
+	std::vector<const ast_assignment*> _assignments;
+	// Indices of the assignments of variables read before them, in ascending order.
+	std::vector<size_t> _forward_read_assignments;
+	const symbol_table* _symbols;
+	std::unique_ptr<dependency_graph> _graph;
+	bool _is_evaluated;
+	std::shared_ptr<std::map<std::string, value>> _variables;
+	std::unique_ptr<thread_pool> _pool;
+	std::vector<std::unique_ptr<step2_evaluator>> _workers;
+	std::map<std::string, value> _parameters;
+	std::stack<value> _values;
+	std::stack<bool> _conditions;
+
+	// Evaluates assignments on another thread over the variables of `owner`.
+	step2_evaluator(const step2_evaluator* owner);
+
+	void execute_level(const std::vector<const ast_assignment*>& level);
+
+	value pop_value();
+
+	bool pop_condition();
+
+	value call_function(const ast_function* function, const std::vector<value>& arguments);
+
+	virtual void visit_assignment(const ast_assignment* assignment);
+
+	virtual void visit_long(const ast_long* _long);
+
+	virtual void visit_double(const ast_double* _double);
+
+	virtual void visit_variable(const ast_variable* variable);
+
+	virtual void visit_call(const ast_call* call);
+
+	virtual void visit_unary_operator(const ast_unary_operator* unary_operator);
+
+	virtual void visit_binary_operator(const ast_binary_operator* binary_operator);
+
+	virtual void visit_logical_binary_operator(const ast_logical_binary_operator* logical_binary_operator);
+
+	virtual void visit_logical_not_operator(const ast_logical_not_operator* logical_not_operator);
+
+	virtual void visit_condition(const ast_condition* condition);
+
+	virtual void visit_if_then_else(const ast_if_then_else* if_then_else);
+};
+
+#endif
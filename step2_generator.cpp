@@ -1,52 +1,90 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <string_view>
+
+#include "dependency_graph.h"
 #include "step2_generator.h"
+#include "value.h"
+
+step2_generator::step2_generator(const table_registry& table_registry, std::ostream& out, const generator_options& options,
+	compilation_cache* cache)
+	: _out(out), _options(options), _cache(cache) {
+	_symbols = &table_registry.symbols();
+	auto input_types = table_registry.input_types();
+	auto output_types = table_registry.output_types();
+
+	// Symbols are listed in alphabetical order, so merging keeps the order.
+	auto input_symbols = table_registry.input_symbols();
+	auto output_symbols = table_registry.output_symbols();
+	auto by_name = [this](symbol_id left, symbol_id right) { return _symbols->name(left) < _symbols->name(right); };
+	std::set_union(input_symbols.cbegin(), input_symbols.cend(), output_symbols.cbegin(), output_symbols.cend(),
+		std::back_inserter(_all_static_variables), by_name);
+
+	// The type of a variable which is both input and output is its input type.
+	_variable_types.assign(_symbols->size(), no_type);
+	for (auto i = _all_static_variables.cbegin(); i != _all_static_variables.cend(); i++) {
+		_variable_types[*i] = input_types[*i] != no_type ? input_types[*i] : output_types[*i];
 
-std::map<std::string, expression_type> set_except(const std::map<std::string, expression_type>& from, const std::map<std::string, expression_type>& what) {
-	auto result = from;
-
-	result.erase(what.cbegin(), what.cend());
-
-	return result;
-}
-
-std::map<std::string, expression_type> set_union(const std::map<std::string, expression_type>& what, const std::map<std::string, expression_type>& with) {
-	auto result = what;
-
-	result.insert(with.cbegin(), with.cend());
-
-	return result;
-}
+		if (output_types[*i] == no_type)
+			_input_only_static_variables.push_back(*i);
+		else if (input_types[*i] == no_type)
+			_output_only_static_variables.push_back(*i);
+	}
 
-step2_generator::step2_generator(const table_registry& table_registry, std::ostream& out) : _out(out) {
-	auto input_variables = table_registry.input_variables();
-	auto output_variables = table_registry.output_variables();
-	_input_only_static_variables = set_except(input_variables, output_variables);
-	_output_only_static_variables = set_except(output_variables, input_variables);
-	_all_static_variables = set_union(input_variables, output_variables);
+	_named_variables.assign(_symbols->size(), std::string());
 	_standard_functions = table_registry.standard_functions();
 	_functions = table_registry.functions();
-	_assignments = table_registry.assignments();
+
+	// Values are consumed right after they are computed, which keeps fewer of them alive.
+	_assignments = dependency_graph(table_registry).locality_order();
+
 }
 
 void step2_generator::print_code() {
 	_last_variable_index = 0;
 
+	if (_options.vector_width > 1) {
+		print_kernel();
+		print_kernel_declarations();
+
+		return;
+	}
+
 	print_declarations();
-	print_input_formats();
-	print_output_formats();
-	print_main_header();
-	print_inputs();
 
-	print_assignments();
+	if (_options.batch) {
+		print_batch_formats();
+		print_main_header();
+		print_batch_inputs();
+
+		print_assignments();
+
+		print_batch_outputs();
+	}
+	else {
+		print_input_formats();
+		print_output_formats();
+		print_main_header();
+		print_inputs();
+
+		print_assignments();
+
+		print_outputs();
+	}
 
-	print_outputs();
 	print_main_footer();
 	print_external_functions();
 }
 
 void step2_generator::print_declarations() {
 	for (auto i = _all_static_variables.cbegin(); i != _all_static_variables.cend(); i++) {
-		auto name = i->first;
-		auto type = i->second;
+		auto name = _symbols->name(*i);
+		auto type = _variable_types[*i];
 
 		if (type == expression_type::Double)
 			_out << "@" << name << " = common global double 0.0e+0, align 8" << std::endl;
@@ -65,14 +103,13 @@ std::string get_input_format(const std::string& variable_name) {
 
 void step2_generator::print_input_formats() {
 	for (auto i = _input_only_static_variables.cbegin(); i != _input_only_static_variables.cend(); i++) {
-		auto name = i->first;
-		auto type = i->second;
+		auto name = _symbols->name(*i);
 
 		_out << "@" << name << ".format = private constant [" << get_input_format_length(name)
 			<< " x i8] " << get_input_format(name) << std::endl;
 	}
 
-	_out << "@i8_input = private constant [4 x i8] c\"%ld\\00\"" << std::endl;
+	_out << "@i64_input = private constant [4 x i8] c\"%ld\\00\"" << std::endl;
 	_out << "@double_input = private constant [4 x i8] c\"%lf\\00\"" << std::endl;
 }
 
@@ -89,23 +126,59 @@ std::string get_output_format(const std::string& name, expression_type type) {
 
 void step2_generator::print_output_formats() {
 	for (auto i = _output_only_static_variables.cbegin(); i != _output_only_static_variables.cend(); i++) {
-		auto name = i->first;
-		auto type = i->second;
+		auto name = _symbols->name(*i);
+		auto type = _variable_types[*i];
 
 		_out << "@" << name << ".format = private constant [" << get_output_format_length(name)
 			<< " x i8] " << get_output_format(name, type) << std::endl;
 	}
 }
 
+// Every input is followed by an optional run of blanks, tabs or commas, so rows can be
+// either whitespace or comma separated. Conversions suppressed by `*` are not counted
+// in the result of scanf, so a successfully read value always returns 1.
+const char* const batch_double_input = "c\"%lf%*[ \\09,]\\00\"";
+const char* const batch_long_input = "c\"%ld%*[ \\09,]\\00\"";
+const size_t batch_input_length = 11;
+
+const char* const malformed_row_format = "c\"Row %ld is malformed.\\0A\\00\"";
+const size_t malformed_row_format_length = 23;
+
+void step2_generator::print_batch_formats() {
+	_out << "@double_batch_input = private constant [" << batch_input_length << " x i8] " << batch_double_input << std::endl;
+	_out << "@i64_batch_input = private constant [" << batch_input_length << " x i8] " << batch_long_input << std::endl;
+
+	std::string format;
+	for (auto i = _output_only_static_variables.cbegin(); i != _output_only_static_variables.cend(); i++) {
+		if (!format.empty())
+			format += ",";
+
+		format += _variable_types[*i] == expression_type::Double ? "%lf" : "%ld";
+	}
+
+	_out << "@row.format = private constant [" << format.length() + 2 << " x i8] c\"" << format << "\\0A\\00\"" << std::endl;
+	_out << "@row.malformed.format = private constant [" << malformed_row_format_length << " x i8] " << malformed_row_format << std::endl;
+	_out << "@row.number = private global i64 0, align 8" << std::endl;
+}
+
 void step2_generator::print_main_header() {
 	_out << "define i32 @main() {" << std::endl;
 	_out << "entry:" << std::endl;
+
+	// Names of the loop have two dots, so they never clash with labels `row.<variable>`.
+	if (_options.batch) {
+		_out << "  br label %row" << std::endl;
+		_out << "row:" << std::endl;
+		_out << "  %row.number.last = load i64, i64* @row.number, align 8" << std::endl;
+		_out << "  %row.number.next = add i64 %row.number.last, 1" << std::endl;
+		_out << "  store i64 %row.number.next, i64* @row.number, align 8" << std::endl;
+	}
 }
 
 void step2_generator::print_inputs() {
 	for (auto i = _input_only_static_variables.cbegin(); i != _input_only_static_variables.cend(); i++) {
-		auto name = i->first;
-		auto type = i->second;
+		auto name = _symbols->name(*i);
+		auto type = _variable_types[*i];
 
 		_out << "  %" << _last_variable_index++ << " = call i32 (i8*, ...) @printf(i8* getelementptr (["
 			<< name.length() + 3 << " x i8], [" << name.length() + 3 << " x i8]* @"
@@ -124,59 +197,215 @@ void step2_generator::print_inputs() {
 	}
 }
 
+void step2_generator::print_batch_inputs() {
+	for (auto i = _input_only_static_variables.cbegin(); i != _input_only_static_variables.cend(); i++) {
+		auto name = _symbols->name(*i);
+		auto type = _variable_types[*i];
+
+		int result_index = get_next_variable_index();
+		if (type == expression_type::Double) {
+			_out << "  %" << result_index << " = call i32 (i8*, ...) @scanf(i8* getelementptr ([" << batch_input_length
+				<< " x i8], [" << batch_input_length << " x i8]* @double_batch_input, i32 0, i32 0), double* nonnull @"
+				<< name << ")" << std::endl;
+		}
+		else {
+			_out << "  %" << result_index << " = call i32 (i8*, ...) @scanf(i8* getelementptr ([" << batch_input_length
+				<< " x i8], [" << batch_input_length << " x i8]* @i64_batch_input, i32 0, i32 0), i64* nonnull @"
+				<< name << ")" << std::endl;
+		}
+
+		int is_read_index = get_next_variable_index();
+		_out << "  %" << is_read_index << " = icmp eq i32 %" << result_index << ", 1" << std::endl;
+
+		// The input ends only before the first value of a row, anything else is a malformed row.
+		if (i != _input_only_static_variables.cbegin()) {
+			_out << "  br i1 %" << is_read_index << ", label %row." << name << ", label %row.malformed.report" << std::endl;
+		}
+		else {
+			_out << "  br i1 %" << is_read_index << ", label %row." << name << ", label %row." << name << ".failed" << std::endl;
+			_out << "row." << name << ".failed:" << std::endl;
+
+			int is_end_index = get_next_variable_index();
+			_out << "  %" << is_end_index << " = icmp eq i32 %" << result_index << ", -1" << std::endl;
+			_out << "  br i1 %" << is_end_index << ", label %done, label %row.malformed.report" << std::endl;
+		}
+
+		_out << "row." << name << ":" << std::endl;
+	}
+}
+
 int step2_generator::get_next_variable_index() {
 	return _last_variable_index++;
 }
 
-int step2_generator::get_named_variable_index(const std::string& variable_name) {
-	if (_named_variables.find(variable_name) == _named_variables.end()) {
-		_named_variables[variable_name] = get_next_variable_index();
+expression_type step2_generator::get_variable_type(symbol_id variable) const {
+	auto type = _variable_types[variable];
+	if (type == no_type)
+		throw new std::runtime_error("Unknown variable `" + _symbols->name(variable) + "`.");
+
+	return type;
+}
+
+std::string step2_generator::get_named_variable_register(symbol_id variable) {
+	auto& variable_register = _named_variables[variable];
 
-		if (get_variable_type(variable_name) == expression_type::Double)
-			_out << "  %" << _named_variables[variable_name] << " = load double, double* @" << variable_name << ", align 8" << std::endl;
+	if (variable_register.empty()) {
+		_named_variable_symbols.push_back(variable);
+
+		if (_options.vector_width > 1) {
+			variable_register = load_column(variable);
+
+			return variable_register;
+		}
+
+		auto& variable_name = _symbols->name(variable);
+		auto type = get_variable_type(variable);
+		variable_register = "%" + std::to_string(get_next_variable_index());
+
+		if (type == expression_type::Double)
+			_out << "  " << variable_register << " = load double, double* @" << variable_name << ", align 8" << std::endl;
 		else
-			_out << "  %" << _named_variables[variable_name] << " = load i64, i64* @" << variable_name << ", align 8" << std::endl;
+			_out << "  " << variable_register << " = load i64, i64* @" << variable_name << ", align 8" << std::endl;
 	}
 
-	return _named_variables[variable_name];
+	return variable_register;
 }
 
-void step2_generator::set_named_variable_index(const std::string& variable_name, expression_node node) {
-	_named_variables[variable_name] = node.index;
+void step2_generator::set_named_variable_register(symbol_id variable, expression_node node) {
+	_named_variables[variable] = node.register_name();
+	_named_variable_symbols.push_back(variable);
+
+	if (_options.vector_width > 1) {
+		store_column(variable, node);
+
+		return;
+	}
+
+	auto& variable_name = _symbols->name(variable);
 
 	if (node.type() == expression_type::Double)
-		_out << "  store double %" << node.index << ", double* @" << variable_name << ", align 8" << std::endl;
+		_out << "  store double " << node.register_name() << ", double* @" << variable_name << ", align 8" << std::endl;
 	else
-		_out << "  store i64 %" << node.index << ", i64* @" << variable_name << ", align 8" << std::endl;
+		_out << "  store i64 " << node.register_name() << ", i64* @" << variable_name << ", align 8" << std::endl;
 }
 
 void step2_generator::print_assignments() {
 	for (auto i = _assignments.cbegin(); i != _assignments.cend(); i++) {
 		auto assignment = *i;
 
+		if (_cache != nullptr)
+			print_cached_assignment(assignment);
+		else
+			assignment->accept(*this);
+	}
+}
+
+void step2_generator::print_cached_assignment(const ast_assignment* assignment) {
+	auto context = std::to_string(_options.vector_width) + " " + std::to_string(_width) + " " + _row_index
+		+ (_options.batch ? " batch" : "");
+	auto key = assignment_key(assignment, *_symbols, _variable_types, context);
+
+	auto fragment = _cache->find(key);
+	if (fragment == nullptr) {
+		_cache->store(key, generate_fragment(assignment));
+		fragment = _cache->find(key);
+	}
+
+	_out << renumber_registers(fragment->code, _last_variable_index);
+	_last_variable_index += fragment->register_count;
+	_vector_declarations.insert(fragment->declarations.cbegin(), fragment->declarations.cend());
+
+	// The following code reads the value from the global, registers of the fragment are unknown.
+	forget_named_variables();
+	_generated_expressions.clear();
+}
+
+void step2_generator::forget_named_variables() {
+	for (auto i = _named_variable_symbols.cbegin(); i != _named_variable_symbols.cend(); i++)
+		_named_variables[*i].clear();
+
+	_named_variable_symbols.clear();
+}
+
+cached_fragment step2_generator::generate_fragment(const ast_assignment* assignment) {
+	auto last_variable_index = _last_variable_index;
+	auto vector_declarations = _vector_declarations;
+
+	_last_variable_index = 0;
+	_vector_declarations.clear();
+	forget_named_variables();
+	_generated_expressions.clear();
+
+	std::ostringstream code;
+	auto buffer = _out.rdbuf(code.rdbuf());
+
+	try {
 		assignment->accept(*this);
 	}
+	catch (...) {
+		_out.rdbuf(buffer);
+
+		throw;
+	}
+
+	_out.rdbuf(buffer);
+
+	cached_fragment fragment{ _last_variable_index, _vector_declarations, code.str() };
+	_last_variable_index = last_variable_index;
+	_vector_declarations = vector_declarations;
+
+	return fragment;
 }
 
 void step2_generator::print_outputs() {
 	for (auto i = _output_only_static_variables.cbegin(); i != _output_only_static_variables.cend(); i++) {
-		auto name = i->first;
-		auto type = i->second;
-		int variable_index = get_named_variable_index(name);
+		auto name = _symbols->name(*i);
+		auto type = _variable_types[*i];
+		auto variable_register = get_named_variable_register(*i);
 
 		if (type == expression_type::Double) {
 			_out << "  %" << get_next_variable_index() << " = call i32 (i8*, ...) @printf(i8* getelementptr (["
 				<< name.length() + 8 << " x i8], [" << name.length() + 8 << " x i8]* @"
-				<< name << ".format, i32 0, i32 0), double %" << variable_index << ")" << std::endl;
+				<< name << ".format, i32 0, i32 0), double " << variable_register << ")" << std::endl;
 		}
 		else {
 			_out << "  %" << get_next_variable_index() << " = call i32 (i8*, ...) @printf(i8* getelementptr (["
 				<< name.length() + 8 << " x i8], [" << name.length() + 8 << " x i8]* @"
-				<< name << ".format, i32 0, i32 0), i64 %" << variable_index << ")" << std::endl;
+				<< name << ".format, i32 0, i32 0), i64 " << variable_register << ")" << std::endl;
 		}
 	}
 }
 
+void step2_generator::print_batch_outputs() {
+	std::string arguments;
+	for (auto i = _output_only_static_variables.cbegin(); i != _output_only_static_variables.cend(); i++) {
+		auto name = _symbols->name(*i);
+		auto type = _variable_types[*i];
+		auto variable_register = get_named_variable_register(*i);
+
+		if (type == expression_type::Double)
+			arguments += ", double " + variable_register;
+		else
+			arguments += ", i64 " + variable_register;
+	}
+
+	size_t format_length = 4 * _output_only_static_variables.size() + 1;
+	_out << "  %" << get_next_variable_index() << " = call i32 (i8*, ...) @printf(i8* getelementptr ([" << format_length
+		<< " x i8], [" << format_length << " x i8]* @row.format, i32 0, i32 0)" << arguments << ")" << std::endl;
+
+	_out << "  br label %row" << std::endl;
+
+	if (!_input_only_static_variables.empty()) {
+		_out << "row.malformed.report:" << std::endl;
+		_out << "  %row.malformed.number = load i64, i64* @row.number, align 8" << std::endl;
+		_out << "  %row.malformed.result = call i32 (i8*, ...) @printf(i8* getelementptr ([" << malformed_row_format_length
+			<< " x i8], [" << malformed_row_format_length << " x i8]* @row.malformed.format, i32 0, i32 0), i64 %row.malformed.number)" << std::endl;
+		_out << "  ret i32 1" << std::endl;
+	}
+
+	_out << "done:" << std::endl;
+}
+
 void step2_generator::print_main_footer() {
 	_out << "  ret i32 0" << std::endl;
 	_out << "}" << std::endl;
@@ -193,53 +422,266 @@ void step2_generator::print_external_functions() {
 	}
 }
 
+// The kernel gets one column pointer per static variable (in alphabetical order) and
+// computes rows [0, n). Rows are processed by `vector_width` at once while a whole
+// vector fits, the rest of them are processed one by one by the scalar tail loop.
+void step2_generator::print_kernel() {
+	int width = _options.vector_width;
+
+	_out << "define void @kernel(i64 %n";
+	for (auto i = _all_static_variables.cbegin(); i != _all_static_variables.cend(); i++) {
+		auto name = _symbols->name(*i);
+		auto type = _variable_types[*i];
+
+		_out << ", " << (type == expression_type::Double ? "double" : "i64") << "* noalias %" << name;
+	}
+	_out << ") {" << std::endl;
+	_out << "entry:" << std::endl;
+	_out << "  br label %vector.check" << std::endl;
+
+	_out << "vector.check:" << std::endl;
+	_out << "  %vector.index = phi i64 [ 0, %entry ], [ %vector.end, %vector.body ]" << std::endl;
+	_out << "  %vector.end = add i64 %vector.index, " << width << std::endl;
+	_out << "  %is_vector = icmp sle i64 %vector.end, %n" << std::endl;
+	_out << "  br i1 %is_vector, label %vector.body, label %scalar.check" << std::endl;
+	_out << "vector.body:" << std::endl;
+	print_kernel_body(width, "%vector.index");
+	_out << "  br label %vector.check" << std::endl;
+
+	_out << "scalar.check:" << std::endl;
+	_out << "  %scalar.index = phi i64 [ %vector.index, %vector.check ], [ %scalar.next, %scalar.body ]" << std::endl;
+	_out << "  %is_scalar = icmp slt i64 %scalar.index, %n" << std::endl;
+	_out << "  br i1 %is_scalar, label %scalar.body, label %exit" << std::endl;
+	_out << "scalar.body:" << std::endl;
+	print_kernel_body(1, "%scalar.index");
+	_out << "  %scalar.next = add i64 %scalar.index, 1" << std::endl;
+	_out << "  br label %scalar.check" << std::endl;
+
+	_out << "exit:" << std::endl;
+	_out << "  ret void" << std::endl;
+	_out << "}" << std::endl;
+}
+
+void step2_generator::print_kernel_body(int width, const std::string& row_index) {
+	_width = width;
+	_row_index = row_index;
+	forget_named_variables();
+	_generated_expressions.clear();
+
+	print_assignments();
+
+	_width = 1;
+}
+
+void step2_generator::print_kernel_declarations() {
+	_out << "declare double @pow(double, double)" << std::endl;
+
+	print_external_functions();
+
+	for (auto i = _vector_declarations.cbegin(); i != _vector_declarations.cend(); i++)
+		_out << *i << std::endl;
+}
+
+std::string step2_generator::get_column_pointer(symbol_id variable) {
+	auto& variable_name = _symbols->name(variable);
+	auto type = get_variable_type(variable);
+	auto scalar_type = type == expression_type::Double ? "double" : "i64";
+
+	int element_index = get_next_variable_index();
+	_out << "  %" << element_index << " = getelementptr inbounds " << scalar_type << ", " << scalar_type << "* %"
+		<< variable_name << ", i64 " << _row_index << std::endl;
+
+	if (_width == 1)
+		return "%" + std::to_string(element_index);
+
+	int vector_index = get_next_variable_index();
+	_out << "  %" << vector_index << " = bitcast " << scalar_type << "* %" << element_index
+		<< " to " << type_name(type) << "*" << std::endl;
+
+	return "%" + std::to_string(vector_index);
+}
+
+std::string step2_generator::load_column(symbol_id variable) {
+	auto type = get_variable_type(variable);
+	auto pointer = get_column_pointer(variable);
+
+	int index = get_next_variable_index();
+	_out << "  %" << index << " = load " << type_name(type) << ", " << type_name(type) << "* " << pointer << ", align 8" << std::endl;
+
+	return "%" + std::to_string(index);
+}
+
+void step2_generator::store_column(symbol_id variable, expression_node node) {
+	auto pointer = get_column_pointer(variable);
+
+	_out << "  store " << operand(node) << ", " << type_name(node.type()) << "* " << pointer << ", align 8" << std::endl;
+}
+
+std::string step2_generator::type_name(expression_type type) const {
+	auto scalar_type = type == expression_type::Double ? "double" : "i64";
+
+	if (_width == 1)
+		return scalar_type;
+
+	return "<" + std::to_string(_width) + " x " + scalar_type + ">";
+}
+
+std::string step2_generator::zero(expression_type type) const {
+	if (_width > 1)
+		return "zeroinitializer";
+
+	return type == expression_type::Double ? "0.0" : "0";
+}
+
+// LLVM reads decimal `double` literals only with a point, and infinities and NaNs
+// only in hexadecimal. The shortest decimal form which reads back exactly is used.
+static std::string double_literal(double value) {
+	if (!std::isfinite(value)) {
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		std::ostringstream out;
+		out << "0x" << std::hex << std::uppercase << std::setw(16) << std::setfill('0') << bits;
+
+		return out.str();
+	}
+
+	std::string result;
+	for (int precision = 15; precision <= 17; precision++) {
+		std::ostringstream out;
+		out << std::setprecision(precision) << value;
+		result = out.str();
+
+		if (std::strtod(result.c_str(), nullptr) == value)
+			break;
+	}
+
+	if (result.find('.') == std::string::npos) {
+		auto exponent = result.find('e');
+		result.insert(exponent == std::string::npos ? result.size() : exponent, ".0");
+	}
+
+	return result;
+}
+
+std::string step2_generator::constant(expression_type type, const std::string& literal) const {
+	if (_width == 1)
+		return literal;
+
+	std::string scalar_type = type == expression_type::Double ? "double " : "i64 ";
+	std::string result = "<";
+	for (int i = 0; i < _width; i++)
+		result += (i == 0 ? "" : ", ") + scalar_type + literal;
+
+	return result + ">";
+}
+
+std::string step2_generator::operand(expression_node node) const {
+	return type_name(node.type()) + " " + node.register_name();
+}
+
+std::string step2_generator::pow_function_name() {
+	if (_width == 1)
+		return "pow";
+
+	auto name = "llvm.pow.v" + std::to_string(_width) + "f64";
+	auto type = type_name(expression_type::Double);
+	_vector_declarations.insert("declare " + type + " @" + name + "(" + type + ", " + type + ")");
+
+	return name;
+}
+
+// Standard functions having LLVM vector intrinsics are called once per vector,
+// the rest of them are called for every lane separately.
+constexpr std::string_view vector_intrinsics[] = { "cos", "exp", "fabs", "log", "log10", "sin", "sqrt" };
+
+expression_node step2_generator::call_vector_function(const std::string& function_name, expression_node parameter) {
+	auto type = type_name(expression_type::Double);
+
+	if (std::find(std::begin(vector_intrinsics), std::end(vector_intrinsics), function_name) != std::end(vector_intrinsics)) {
+		auto name = "llvm." + function_name + ".v" + std::to_string(_width) + "f64";
+		_vector_declarations.insert("declare " + type + " @" + name + "(" + type + ")");
+
+		int index = get_next_variable_index();
+		_out << "  %" << index << " = call " << type << " @" << name << "(" << operand(parameter) << ")" << std::endl;
+
+		return expression_node(expression_type::Double, "%" + std::to_string(index));
+	}
+
+	std::string result = "undef";
+	for (int lane = 0; lane < _width; lane++) {
+		int element_index = get_next_variable_index();
+		_out << "  %" << element_index << " = extractelement " << operand(parameter) << ", i32 " << lane << std::endl;
+
+		int call_index = get_next_variable_index();
+		_out << "  %" << call_index << " = call double @" << function_name << "(double %" << element_index << ")" << std::endl;
+
+		int insert_index = get_next_variable_index();
+		_out << "  %" << insert_index << " = insertelement " << type << " " << result << ", double %" << call_index
+			<< ", i32 " << lane << std::endl;
+
+		result = "%" + std::to_string(insert_index);
+	}
+
+	return expression_node(expression_type::Double, result);
+}
+
 expression_node step2_generator::cast_to_double(expression_node node) {
 	int index = get_next_variable_index();
 
-	_out << "  %" << index << " = sitofp i64 %" << node.index << " to double" << std::endl;
+	_out << "  %" << index << " = sitofp " << operand(node) << " to " << type_name(expression_type::Double) << std::endl;
+
+	return expression_node(expression_type::Double, "%" + std::to_string(index));
+}
+
+// Nodes shared by expression_dag are generated once, the following uses take the same register.
+void step2_generator::generate(const ast_expression* expression) {
+	auto generated = _generated_expressions.find(expression);
+	if (generated != _generated_expressions.end()) {
+		_expressions.push(generated->second);
+
+		return;
+	}
 
-	return expression_node(index, expression_type::Double);
+	expression->accept(*this);
+	_generated_expressions.emplace(expression, _expressions.top());
 }
 
 void step2_generator::visit_assignment(const ast_assignment* assignment) {
-	auto declared_identifier = assignment->name();
-	visitor::visit_assignment(assignment);
+	auto declared_identifier = assignment->symbol();
+	generate(assignment->expression());
 
 	auto expression = _expressions.top();
 	_expressions.pop();
 
-	if (get_variable_type(declared_identifier) != expression._type)
-		throw new std::runtime_error("Incompatible type of variable `" + declared_identifier + "`.");
+	if (get_variable_type(declared_identifier) != expression.type())
+		throw new std::runtime_error("Incompatible type of variable `" + assignment->name() + "`.");
 
-	set_named_variable_index(declared_identifier, expression);
+	set_named_variable_register(declared_identifier, expression);
 }
 
+// Constants are used as immediate operands of instructions, no register is spent on them.
 void step2_generator::visit_long(const ast_long* _long) {
-	int index = get_next_variable_index();
-
-	_out << "  %" << index << " = add i64 0, " << _long->value() << std::endl;
-
-	_expressions.push(expression_node(index, expression_type::Long));
+	_expressions.push(expression_node(expression_type::Long, constant(expression_type::Long, std::to_string(_long->value()))));
 }
 
 void step2_generator::visit_double(const ast_double* _double) {
-	int index = get_next_variable_index();
-
-	_out << "  %" << index << " = fadd double 0.0, " << _double->value() << std::endl;
-
-	_expressions.push(expression_node(index, expression_type::Double));
+	_expressions.push(expression_node(expression_type::Double, constant(expression_type::Double, double_literal(_double->value()))));
 }
 
 void step2_generator::visit_variable(const ast_variable* variable) {
-	auto name = variable->name();
 	expression_type type = variable->type();
-	int index = get_named_variable_index(name);
+	auto variable_register = get_named_variable_register(variable->symbol());
 
-	_expressions.push(expression_node(index, type));
+	_expressions.push(expression_node(type, variable_register));
 }
 
 void step2_generator::visit_call(const ast_call* call) {
-	visitor::visit_call(call);
+	if (find_unary_standard_function(call->name()) == nullptr && find_binary_standard_function(call->name()) == nullptr)
+		throw new std::runtime_error("Calls of user function `" + call->name() + "` are not supported.");
+
+	for (auto i = call->parameters().cbegin(); i != call->parameters().cend(); i++)
+		generate(*i);
 
 	if (call->parameters().size() > 1)
 		throw new std::runtime_error("Functions with more than 1 parameter are not supported.");
@@ -247,32 +689,42 @@ void step2_generator::visit_call(const ast_call* call) {
 	auto parameter = _expressions.top();
 	_expressions.pop();
 
+	if (parameter.type() == expression_type::Long)
+		parameter = cast_to_double(parameter);
+
+	if (_width > 1) {
+		_expressions.push(call_vector_function(call->name(), parameter));
+
+		return;
+	}
+
 	int index = get_next_variable_index();
-	_out << "  %" << index << " = call double @" << call->name() << "(" << get_node_as_text(parameter) << ")" << std::endl;
+	_out << "  %" << index << " = call double @" << call->name() << "(" << parameter.to_string() << ")" << std::endl;
 
-	_expressions.push(expression_node(index, expression_type::Double));
+	_expressions.push(expression_node(expression_type::Double, "%" + std::to_string(index)));
 }
 
 void step2_generator::visit_unary_operator(const ast_unary_operator* unary_operator) {
-	visitor::visit_unary_operator(unary_operator);
+	generate(unary_operator->operand());
 
 	if (unary_operator->operation() == unary_operation::Positive)
 		return;
 
-	expression_node operand = _expressions.top();
+	expression_node value = _expressions.top();
 	_expressions.pop();
 
 	int index = get_next_variable_index();
-	if (operand.type() == expression_type::Double)
-		_out << "  %" << index << +" = fsub double 0.0, %" << operand.index << std::endl;
+	if (value.type() == expression_type::Double)
+		_out << "  %" << index << " = fsub " << type_name(value.type()) << " " << zero(value.type()) << ", " << value.register_name() << std::endl;
 	else
-		_out << "  %" << index << +" = sub i64 0, %" << operand.index << std::endl;
+		_out << "  %" << index << " = sub " << type_name(value.type()) << " " << zero(value.type()) << ", " << value.register_name() << std::endl;
 
-	_expressions.push(expression_node(index, operand._type));
+	_expressions.push(expression_node(value.type(), "%" + std::to_string(index)));
 }
 
 void step2_generator::visit_binary_operator(const ast_binary_operator* binary_operator) {
-	visitor::visit_binary_operator(binary_operator);
+	generate(binary_operator->left());
+	generate(binary_operator->right());
 
 	expression_node right = _expressions.top();
 	_expressions.pop();
@@ -280,44 +732,48 @@ void step2_generator::visit_binary_operator(const ast_binary_operator* binary_op
 	expression_node left = _expressions.top();
 	_expressions.pop();
 
-	if (left._type == expression_type::Double && right._type == expression_type::Long)
+	if (left.type() == expression_type::Double && right.type() == expression_type::Long)
 		right = cast_to_double(right);
-	else if (left._type == expression_type::Long && right._type == expression_type::Double)
+	else if (left.type() == expression_type::Long && right.type() == expression_type::Double)
 		left = cast_to_double(left);
-	else if (left._type == expression_type::Long && right._type == expression_type::Long && binary_operator->operation() == "^") {
+	else if (left.type() == expression_type::Long && right.type() == expression_type::Long && binary_operator->operation() == binary_operation::Pow) {
 		left = cast_to_double(left);
 		right = cast_to_double(right);
 	}
 
 	int index = get_next_variable_index();
-	expression_type type = left._type;
+	expression_type type = left.type();
 
 	if (type == expression_type::Double) {
-		if (binary_operator->operation() == "+")
-			_out << "  %" << index << " = fadd double %" << left.index << ", %" << right.index << std::endl;
-		else if (binary_operator->operation() == "-")
-			_out << "  %" << index << " = fsub double %" << left.index << ", %" << right.index << std::endl;
-		else if (binary_operator->operation() == "*")
-			_out << "  %" << index << " = fmul double %" << left.index << ", %" << right.index << std::endl;
-		else if (binary_operator->operation() == "/")
-			_out << "  %" << index << " = fdiv double %" << left.index << ", %" << right.index << std::endl;
-		else if (binary_operator->operation() == "%")
-			_out << "  %" << index << " = frem double %" << left.index << ", %" << right.index << std::endl;
-		else if (binary_operator->operation() == "^")
-			_out << "  %" << index << " = call double @pow(double %" << left.index << ", double %" << right.index << ")" << std::endl;
+		if (binary_operator->operation() == binary_operation::Add)
+			_out << "  %" << index << " = fadd " << type_name(type) << " " << left.register_name() << ", " << right.register_name() << std::endl;
+		else if (binary_operator->operation() == binary_operation::Subtract)
+			_out << "  %" << index << " = fsub " << type_name(type) << " " << left.register_name() << ", " << right.register_name() << std::endl;
+		else if (binary_operator->operation() == binary_operation::Multiply)
+			_out << "  %" << index << " = fmul " << type_name(type) << " " << left.register_name() << ", " << right.register_name() << std::endl;
+		else if (binary_operator->operation() == binary_operation::Divide)
+			_out << "  %" << index << " = fdiv " << type_name(type) << " " << left.register_name() << ", " << right.register_name() << std::endl;
+		else if (binary_operator->operation() == binary_operation::Reminder)
+			_out << "  %" << index << " = frem " << type_name(type) << " " << left.register_name() << ", " << right.register_name() << std::endl;
+		else if (binary_operator->operation() == binary_operation::Pow)
+			_out << "  %" << index << " = call " << type_name(type) << " @" << pow_function_name() << "(" << operand(left) << ", " << operand(right) << ")" << std::endl;
 	}
 	else {
-		if (binary_operator->operation() == "+")
-			_out << "  %" << index << " = add i64 %" << left.index << ", %" << right.index << std::endl;
-		else if (binary_operator->operation() == "-")
-			_out << "  %" << index << " = sub i64 %" << left.index << ", %" << right.index << std::endl;
-		else if (binary_operator->operation() == "*")
-			_out << "  %" << index << " = mul i64 %" << left.index << ", %" << right.index << std::endl;
-		else if (binary_operator->operation() == "/")
-			_out << "  %" << index << " = sdiv i64 %" << left.index << ", %" << right.index << std::endl;
-		else if (binary_operator->operation() == "%")
-			_out << "  %" << index << " = srem i64 %" << left.index << ", %" << right.index << std::endl;
-	}
-
-	_expressions.push(expression_node(index, type));
+		if (binary_operator->operation() == binary_operation::Add)
+			_out << "  %" << index << " = add " << type_name(type) << " " << left.register_name() << ", " << right.register_name() << std::endl;
+		else if (binary_operator->operation() == binary_operation::Subtract)
+			_out << "  %" << index << " = sub " << type_name(type) << " " << left.register_name() << ", " << right.register_name() << std::endl;
+		else if (binary_operator->operation() == binary_operation::Multiply)
+			_out << "  %" << index << " = mul " << type_name(type) << " " << left.register_name() << ", " << right.register_name() << std::endl;
+		else if (binary_operator->operation() == binary_operation::Divide)
+			_out << "  %" << index << " = sdiv " << type_name(type) << " " << left.register_name() << ", " << right.register_name() << std::endl;
+		else if (binary_operator->operation() == binary_operation::Reminder)
+			_out << "  %" << index << " = srem " << type_name(type) << " " << left.register_name() << ", " << right.register_name() << std::endl;
+	}
+
+	_expressions.push(expression_node(type, "%" + std::to_string(index)));
+}
+
+void step2_generator::visit_if_then_else(const ast_if_then_else*) {
+	throw new std::runtime_error("Conditional expressions are not supported.");
 }
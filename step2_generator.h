@@ -6,30 +6,48 @@
 #include <set>
 #include <stack>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "ast.h"
+#include "compilation_cache.h"
+#include "generator_options.h"
 #include "table_registry.h"
 
 class step2_generator : private visitor
 {
 public:
-	step2_generator(const table_registry& table_registry, std::ostream& out);
+	// With a cache, every assignment is generated separately and passes its value to the
+	// following ones through its global, so its code can be taken from the cache.
+	step2_generator(const table_registry& table_registry, std::ostream& out, const generator_options& options = generator_options(),
+		compilation_cache* cache = nullptr);
 
 	void print_code();
 
+	// Registers numbered by the printed code.
+	int register_count() const { return _last_variable_index; }
+
 private:
-	std::map<std::string, expression_type> _input_only_static_variables;
-	std::map<std::string, expression_type> _output_only_static_variables;
-	std::map<std::string, expression_type> _all_static_variables;
-	std::map<std::string, expression_type> _all_local_variables;
+	// Static variables are referred to by symbol ids. Lists are in alphabetical order of names.
+	const symbol_table* _symbols;
+	std::vector<symbol_id> _input_only_static_variables;
+	std::vector<symbol_id> _output_only_static_variables;
+	std::vector<symbol_id> _all_static_variables;
+	std::vector<expression_type> _variable_types;
 	std::set<std::string> _standard_functions;
 	std::vector<const ast_function*> _functions;
 	std::vector<const ast_assignment*> _assignments;
 	std::ostream& _out;
-	std::map<std::string, int> _named_variables;
+	generator_options _options;
+	compilation_cache* _cache;
+	std::vector<std::string> _named_variables;
+	std::vector<symbol_id> _named_variable_symbols;
 	std::stack<expression_node> _expressions;
+	std::unordered_map<const ast_expression*, expression_node> _generated_expressions;
 	int _last_variable_index = 0;
+	int _width = 1;
+	std::string _row_index;
+	std::set<std::string> _vector_declarations;
 
 	void print_declarations();
 
@@ -37,26 +55,67 @@ private:
 
 	void print_output_formats();
 
+	void print_batch_formats();
+
 	void print_main_header();
 
 	void print_inputs();
 
+	void print_batch_inputs();
+
 	int get_next_variable_index();
 
-	int get_named_variable_index(const std::string& variable_name);
+	expression_type get_variable_type(symbol_id variable) const;
 
-	void set_named_variable_index(const std::string& variable_name, expression_node node);
+	std::string get_named_variable_register(symbol_id variable);
+
+	void set_named_variable_register(symbol_id variable, expression_node node);
 
 	void print_assignments();
 
+	void print_cached_assignment(const ast_assignment* assignment);
+
+	// Clears registers of named variables set since the last call, not the whole table.
+	void forget_named_variables();
+
+	cached_fragment generate_fragment(const ast_assignment* assignment);
+
 	void print_outputs();
 
+	void print_batch_outputs();
+
 	void print_main_footer();
 
 	void print_external_functions();
 
+	void print_kernel();
+
+	void print_kernel_body(int width, const std::string& row_index);
+
+	void print_kernel_declarations();
+
+	std::string get_column_pointer(symbol_id variable);
+
+	std::string load_column(symbol_id variable);
+
+	void store_column(symbol_id variable, expression_node node);
+
+	std::string type_name(expression_type type) const;
+
+	std::string zero(expression_type type) const;
+
+	std::string constant(expression_type type, const std::string& literal) const;
+
+	std::string operand(expression_node node) const;
+
+	std::string pow_function_name();
+
+	expression_node call_vector_function(const std::string& function_name, expression_node parameter);
+
 	expression_node cast_to_double(expression_node node);
 
+	void generate(const ast_expression* expression);
+
 	virtual void visit_assignment(const ast_assignment* assignment);
 
 	virtual void visit_long(const ast_long* _long);
@@ -70,6 +129,8 @@ private:
 	virtual void visit_unary_operator(const ast_unary_operator* unary_operator);
 
 	virtual void visit_binary_operator(const ast_binary_operator* binary_operator);
+
+	virtual void visit_if_then_else(const ast_if_then_else* if_then_else);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,19 @@
+#include "symbol_table.h"
+
+symbol_id symbol_table::intern(std::string_view name) {
+	auto id = _ids.find(name);
+	if (id != _ids.end())
+		return id->second;
+
+	symbol_id result = (symbol_id)_names.size();
+	_names.emplace_back(name);
+	_ids.emplace(std::string_view(_names.back()), result);
+
+	return result;
+}
+
+symbol_id symbol_table::find(std::string_view name) const {
+	auto id = _ids.find(name);
+
+	return id != _ids.end() ? id->second : no_symbol;
+}
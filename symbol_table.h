@@ -0,0 +1,40 @@
+#ifndef __SYMBOL_TABLE_H__
+#define __SYMBOL_TABLE_H__
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Dense id of an interned identifier. Ids start with 0 in the order names are first met,
+// so passes can keep per-name data in vectors indexed by id instead of maps.
+typedef int symbol_id;
+
+const symbol_id no_symbol = -1;
+
+// Program-wide identifier interner. Every distinct name is stored once, and the stored
+// strings never move, so references to them stay valid while the table is alive.
+class symbol_table
+{
+private:
+	std::deque<std::string> _names;
+	std::unordered_map<std::string_view, symbol_id> _ids;
+
+public:
+	symbol_table() { }
+
+	symbol_table(const symbol_table&) = delete;
+
+	symbol_table& operator=(const symbol_table&) = delete;
+
+	symbol_id intern(std::string_view name);
+
+	// Returns no_symbol if the name has never been interned.
+	symbol_id find(std::string_view name) const;
+
+	const std::string& name(symbol_id id) const { return _names[id]; }
+
+	size_t size() const { return _names.size(); }
+};
+
+#endif
@@ -1,23 +1,59 @@
 #ifndef __TABLE_REGISTRY_H__
 #define __TABLE_REGISTRY_H__
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <string>
 #include <vector>
 
 #include "ast.h"
+#include "symbol_table.h"
 
 class table_registry
 {
 private:
+	const symbol_table* _symbols;
+	std::vector<expression_type> _input_types;
+	std::vector<expression_type> _output_types;
+	std::vector<symbol_id> _input_symbols;
+	std::vector<symbol_id> _output_symbols;
 	std::map<std::string, expression_type> _input_variables;
 	std::map<std::string, expression_type> _output_variables;
 	std::set<std::string> _standard_functions;
 	std::vector<const ast_function*> _functions;
 	std::vector<const ast_assignment*> _assignments;
 
+	std::vector<symbol_id> sorted_symbols(const std::vector<expression_type>& types, std::map<std::string, expression_type>& variables) {
+		std::vector<symbol_id> result;
+		for (size_t i = 0; i < types.size(); i++) {
+			if (types[i] != no_type)
+				result.push_back((symbol_id)i);
+		}
+
+		std::sort(result.begin(), result.end(), [this](symbol_id left, symbol_id right) {
+			return _symbols->name(left) < _symbols->name(right);
+		});
+
+		for (auto i = result.cbegin(); i != result.cend(); i++)
+			variables[_symbols->name(*i)] = types[*i];
+
+		return result;
+	}
+
 public:
+	const symbol_table& symbols() const { return *_symbols; }
+
+	// Types of static variables indexed by symbol id, no_type for the rest of symbols.
+	const std::vector<expression_type>& input_types() const { return _input_types; }
+
+	const std::vector<expression_type>& output_types() const { return _output_types; }
+
+	// Symbols of static variables in alphabetical order of their names.
+	const std::vector<symbol_id>& input_symbols() const { return _input_symbols; }
+
+	const std::vector<symbol_id>& output_symbols() const { return _output_symbols; }
+
 	const std::map<std::string, expression_type>& input_variables() const { return _input_variables; }
 
 	const std::map<std::string, expression_type>& output_variables() const { return _output_variables; }
@@ -29,14 +65,18 @@ public:
 	const std::vector<const ast_assignment*>& assignments() const { return _assignments; }
 
 	table_registry(
-		std::map<std::string, expression_type> input_variables,
-		std::map<std::string, expression_type> output_variables,
+		const symbol_table* symbols,
+		std::vector<expression_type> input_types,
+		std::vector<expression_type> output_types,
 		std::set<std::string> standard_functions,
 		std::vector<const ast_function*> functions,
 		std::vector<const ast_assignment*> assignments)
 	{
-		_input_variables = input_variables;
-		_output_variables = output_variables;
+		_symbols = symbols;
+		_input_types = input_types;
+		_output_types = output_types;
+		_input_symbols = sorted_symbols(_input_types, _input_variables);
+		_output_symbols = sorted_symbols(_output_types, _output_variables);
 		_standard_functions = standard_functions;
 		_functions = functions;
 		_assignments = assignments;
@@ -0,0 +1,95 @@
+#include "tail_recursion.h"
+
+// Tells the kind of an expression node without visiting its children.
+class expression_node_kind : private visitor
+{
+private:
+	virtual void visit_binary_operator(const ast_binary_operator* binary_operator) { this->binary_operator = binary_operator; }
+
+	virtual void visit_unary_operator(const ast_unary_operator*) { }
+
+	virtual void visit_call(const ast_call* call) { this->call = call; }
+
+	virtual void visit_if_then_else(const ast_if_then_else* if_then_else) { this->if_then_else = if_then_else; }
+
+public:
+	const ast_binary_operator* binary_operator;
+	const ast_call* call;
+	const ast_if_then_else* if_then_else;
+
+	expression_node_kind(const ast_expression* expression) : binary_operator(nullptr), call(nullptr), if_then_else(nullptr) {
+		expression->accept(*this);
+	}
+};
+
+tail_recursion::tail_recursion(const ast_function* function)
+	: _function(function), _is_loop(false), _has_accumulator(false), _accumulator_operation(binary_operation::Add) {
+	scan(function->expression(), true);
+}
+
+const ast_call* tail_recursion::as_self_call(const ast_expression* expression) const {
+	auto call = expression_node_kind(expression).call;
+	if (call == nullptr || call->symbol() != _function->symbol())
+		return nullptr;
+
+	return call;
+}
+
+void tail_recursion::scan(const ast_expression* expression, bool is_exact) {
+	expression_node_kind node(expression);
+
+	if (node.if_then_else != nullptr) {
+		is_exact = is_exact && node.if_then_else->type() == _function->expression()->type();
+
+		scan(node.if_then_else->then_expression(), is_exact);
+		scan(node.if_then_else->else_expression(), is_exact);
+
+		return;
+	}
+
+	if (is_exact && !_has_accumulator && node.binary_operator != nullptr) {
+		// Reassociation is exact for `long` only.
+		auto operation = node.binary_operator->operation();
+		bool is_accumulating = (operation == binary_operation::Add || operation == binary_operation::Multiply)
+			&& _function->expression()->type() == expression_type::Long
+			&& node.binary_operator->type() == expression_type::Long
+			&& (as_self_call(node.binary_operator->left()) != nullptr || as_self_call(node.binary_operator->right()) != nullptr);
+
+		if (is_accumulating) {
+			_has_accumulator = true;
+			_accumulator_operation = operation;
+		}
+	}
+
+	auto kind = classify(expression, is_exact).kind;
+	if (kind == tail_kind::Call || kind == tail_kind::Accumulate)
+		_is_loop = true;
+}
+
+tail_expression tail_recursion::classify(const ast_expression* expression, bool is_exact) const {
+	expression_node_kind node(expression);
+
+	if (node.if_then_else != nullptr)
+		return tail_expression{ tail_kind::Branch, node.if_then_else, nullptr, nullptr };
+
+	if (!is_exact)
+		return tail_expression{ tail_kind::Value, nullptr, nullptr, expression };
+
+	auto call = as_self_call(expression);
+	if (call != nullptr)
+		return tail_expression{ tail_kind::Call, nullptr, call, nullptr };
+
+	auto binary_operator = node.binary_operator;
+	if (_has_accumulator && binary_operator != nullptr && binary_operator->operation() == _accumulator_operation
+		&& binary_operator->type() == expression_type::Long) {
+		call = as_self_call(binary_operator->right());
+		if (call != nullptr)
+			return tail_expression{ tail_kind::Accumulate, nullptr, call, binary_operator->left() };
+
+		call = as_self_call(binary_operator->left());
+		if (call != nullptr)
+			return tail_expression{ tail_kind::Accumulate, nullptr, call, binary_operator->right() };
+	}
+
+	return tail_expression{ tail_kind::Value, nullptr, nullptr, expression };
+}
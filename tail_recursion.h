@@ -0,0 +1,59 @@
+#ifndef __TAIL_RECURSION_H__
+#define __TAIL_RECURSION_H__
+
+#include "ast.h"
+
+// What a lowering does with an expression in tail position of a function body.
+enum class tail_kind
+{
+	Value,      // returned, combined with the accumulator if there is one
+	Branch,     // if-then-else, both branches are in tail position too
+	Call,       // self-call: parameters take the arguments and the loop restarts
+	Accumulate, // `operand op call` or `call op operand`: the accumulator takes the operand, then as Call
+};
+
+struct tail_expression
+{
+	tail_kind kind;
+	const ast_if_then_else* branch;
+	const ast_call* call;
+	const ast_expression* operand;
+};
+
+// Finds self-calls in tail position of a function, and `long` sums and products
+// of a self-call, so the function can be lowered to a loop instead of recursion.
+// Self-calls elsewhere stay real calls.
+//
+//   gcd(a, b) = if b = 0 then a else gcd(b, a % b)   -- loop
+//   sum(n) = if n = 0 then 0 else n + sum(n - 1)     -- loop with accumulator `+`
+class tail_recursion
+{
+private:
+	const ast_function* _function;
+	bool _is_loop;
+	bool _has_accumulator;
+	binary_operation _accumulator_operation;
+
+	const ast_call* as_self_call(const ast_expression* expression) const;
+
+	void scan(const ast_expression* expression, bool is_exact);
+
+public:
+	tail_recursion(const ast_function* function);
+
+	const ast_function* function() const { return _function; }
+
+	bool is_loop() const { return _is_loop; }
+
+	bool has_accumulator() const { return _has_accumulator; }
+
+	// Add or Multiply. The accumulator starts with 0 or 1 respectively.
+	binary_operation accumulator_operation() const { return _accumulator_operation; }
+
+	// `is_exact` tells that all the enclosing branches have the result type of the function,
+	// so the result of a self-call would be returned without conversions. Otherwise the
+	// expression is a Value or a Branch.
+	tail_expression classify(const ast_expression* expression, bool is_exact) const;
+};
+
+#endif
@@ -0,0 +1,138 @@
+// Scans, parses and generates many programs on several threads at once, and checks that
+// every thread gets the code a single thread gets. Built with -fsanitize=thread, so a
+// data race in the shared tables of the front end (the names of lexemes, the signatures
+// of standard functions) or in the generator fails the test.
+//
+//   concurrency_test [threads] [rounds]
+
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../generator.h"
+#include "../parser.h"
+#include "../scanner.h"
+
+static const int program_count = 24;
+
+// Programs of several shapes, with standard functions and both types. User functions with
+// conditions are defined but not called, the generator does not support them. Every fifth
+// program is invalid, so error paths run concurrently too.
+static std::string generate_program(int index) {
+	std::ostringstream out;
+
+	if (index % 5 == 4) {
+		out << "y = sqrt(a" << index << ", 2)" << std::endl;
+
+		return out.str();
+	}
+
+	out << "f(x) = if x > 0 then x * 2.5 else -x" << std::endl;
+	out << "g(n) = n % 3 + 1" << std::endl;
+
+	for (int i = 0; i < 10 + index; i++) {
+		out << "y" << i << " = ";
+
+		switch ((index + i) % 4) {
+		case 0:
+			out << "a + " << i << " * b ^ 2 - sin(c) / (b + 1.5)";
+			break;
+		case 1:
+			out << "atan(a / b) + sqrt(fabs(a - " << i << ")) + exp(log(fabs(c) + 1))";
+			break;
+		case 2:
+			out << "cos(a) * (i % 3 + 1) - (j - " << i << ") / (c + 1.5)";
+			break;
+		default:
+			out << "-(i + " << i << ") * k % 7 + j";
+			break;
+		}
+
+		out << std::endl;
+	}
+
+	return out.str();
+}
+
+// Returns the code of the program or the message of its error.
+static std::string compile(const std::string& text) {
+	try {
+		size_t lexemes = 0;
+		std::string names;
+
+		for (scanner scanner(text); scanner.lexeme() != lexeme::Eof; scanner.next()) {
+			names += scanner::name(scanner.lexeme());
+			lexemes++;
+		}
+
+		parser parser(text);
+		const ast_program* program = parser.parse_program();
+
+		std::ostringstream out;
+		try {
+			generate(program, out);
+		}
+		catch (...) {
+			delete program;
+
+			throw;
+		}
+
+		delete program;
+
+		return std::to_string(lexemes) + " " + std::to_string(names.size()) + "\n" + out.str();
+	}
+	catch (std::exception* exception) {
+		std::string message = exception->what();
+		delete exception;
+
+		return "error: " + message;
+	}
+}
+
+int main(int argc, const char* const* argv) {
+	int thread_count = argc > 1 ? std::stoi(argv[1]) : 8;
+	int rounds = argc > 2 ? std::stoi(argv[2]) : 4;
+
+	std::vector<std::string> programs;
+	std::vector<std::string> expected;
+	for (int i = 0; i < program_count; i++) {
+		programs.push_back(generate_program(i));
+		expected.push_back(compile(programs.back()));
+	}
+
+	std::atomic<int> failures(0);
+	std::vector<std::thread> threads;
+
+	for (int t = 0; t < thread_count; t++) {
+		threads.emplace_back([&, t]() {
+			for (int round = 0; round < rounds; round++) {
+				// Threads start at different programs, so different programs run at once.
+				for (int i = 0; i < program_count; i++) {
+					int index = (i + t * 3) % program_count;
+
+					if (compile(programs[index]) != expected[index])
+						failures++;
+				}
+			}
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	if (failures != 0) {
+		std::cerr << failures << " compilations differ from the single-threaded ones." << std::endl;
+
+		return 1;
+	}
+
+	std::cout << thread_count << " threads compiled " << program_count << " programs "
+		<< rounds << " times each." << std::endl;
+
+	return 0;
+}
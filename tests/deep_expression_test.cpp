@@ -0,0 +1,90 @@
+// Runs the driver on a sum of a million terms, a tree a million levels deep, and checks
+// that it generates code and evaluates the sum with every engine. The passes after
+// parsing are recursive, so the driver has to run them on a stack sized for the depth.
+//
+//   deep_expression_test path/to/comcalc [terms]
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// `a + 2 - a + 2 ...`, every term changes the sum, so a lost term changes the result.
+static std::string generate_sum(int terms) {
+	std::string text = "y = a";
+	for (int j = 1; j < terms; j++)
+		text += j % 2 == 0 ? " - a" : " + 2";
+
+	return text + "\n";
+}
+
+static std::string read_file(const std::filesystem::path& path) {
+	std::ifstream in(path);
+	std::ostringstream text;
+	text << in.rdbuf();
+
+	return text.str();
+}
+
+// Runs the driver with `arguments`, returns its exit code and leaves its output in `output`.
+static int run(const std::string& comcalc, const std::string& arguments, const std::filesystem::path& output) {
+	std::string command = "\"" + comcalc + "\" " + arguments + " > \"" + output.string() + "\" 2>&1";
+
+	return std::system(command.c_str());
+}
+
+static bool check(bool condition, const std::string& what, const std::filesystem::path& output) {
+	if (!condition)
+		std::cerr << what << " failed:" << std::endl << read_file(output) << std::endl;
+
+	return condition;
+}
+
+int main(int argc, const char* const* argv) {
+	if (argc < 2) {
+		std::cerr << "Usage: deep_expression_test path/to/comcalc [terms]" << std::endl;
+
+		return 1;
+	}
+
+	std::string comcalc = argv[1];
+	int terms = argc > 2 ? std::stoi(argv[2]) : 1000000;
+
+	auto directory = std::filesystem::temp_directory_path() / ("comcalc_deep_" + std::to_string(terms));
+	std::filesystem::create_directories(directory);
+	auto source = directory / "sum.cc";
+	auto code = directory / "sum.ll";
+	auto output = directory / "output.txt";
+
+	std::ofstream(source) << generate_sum(terms);
+
+	// With a = 1 the terms `+ 2` add terms / 2 * 2 and the terms `- a` subtract (terms - 1) / 2.
+	std::string expected = "y = " + std::to_string(1 + terms / 2 * 2 - (terms - 1) / 2) + ".000000";
+	std::string quoted_source = "\"" + source.string() + "\"";
+	bool is_passed = true;
+
+	std::filesystem::remove(code);
+	is_passed &= check(run(comcalc, quoted_source + " \"" + code.string() + "\"", output) == 0
+		&& std::filesystem::exists(code) && std::filesystem::file_size(code) > 0, "Generation", output);
+
+	std::filesystem::remove(code);
+	is_passed &= check(run(comcalc, quoted_source + " \"" + code.string() + "\" --stats", output) == 0
+		&& std::filesystem::exists(code) && std::filesystem::file_size(code) > 0, "Generation with statistics", output);
+
+	is_passed &= check(run(comcalc, quoted_source + " --eval a=1", output) == 0
+		&& read_file(output).find(expected) != std::string::npos, "Evaluation", output);
+
+	is_passed &= check(run(comcalc, quoted_source + " --vm a=1", output) == 0
+		&& read_file(output).find(expected) != std::string::npos, "Evaluation on the bytecode VM", output);
+
+	std::filesystem::remove_all(directory);
+
+	if (!is_passed)
+		return 1;
+
+	std::cout << "The driver generated and evaluated a sum of " << terms << " terms." << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,156 @@
+// Evaluates programs with every engine and checks that they print the same outputs or
+// fail with the same message. The JIT takes part when comcalc is built with LLVM.
+//
+// `double` outputs are compared with a tolerance: LLVM folds operations with constant
+// operands after inlining, which may round the last bit differently, and a NaN it folds
+// is positive while a NaN computed on x86 is negative. `^` and `%` are not folded, the
+// JIT calls the same std::pow and std::fmod as the evaluators.
+//
+//   engine_agreement_test
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../evaluator.h"
+#include "../parser.h"
+
+struct test_case
+{
+	const char* text;
+	std::map<std::string, std::string> arguments;
+};
+
+// Reads of parameters are typed by their own annotations, whatever type the parameter
+// has, so every engine converts the value at the read.
+static const test_case test_cases[] =
+{
+	{ "f(acc:long) = acc / 2\ny = f(5)\nz = f(a)\n", { { "a", "7" } } },
+	{ "f(acc:long) = acc:long / 2\ny = f(5)\nz = f(a)\n", { { "a", "7" } } },
+	{ "f(n:long) = n:long % 3 + n / 4\ny = f(a)\n", { { "a", "10" } } },
+	{ "f(x) = x:long * 2\ny = f(2.7)\nz = f(a)\n", { { "a", "-3.5" } } },
+	{ "f(x:long, y) = x * y:long - y\nz = f(a, b)\n", { { "a", "3.9" }, { "b", "2.5" } } },
+	{ "sum(n:long, acc:long) = if n:long = 0 then acc:long else sum(n:long - 1, acc + n)\ny = sum(a, 0)\n", { { "a", "10" } } },
+	{ "f(acc:long) = acc:long % 0\ny = f(5)\n", { } },
+	{ "f(acc:long) = acc:long / 0\ny = f(a)\n", { { "a", "1" } } },
+	{ "f(x) = x % 0\ny = f(5)\nz = a ^ 0.37 + b % 0.3 + 2.5 ^ b\n", { { "a", "3.3" }, { "b", "7.1" } } },
+	{ "f(x) = x ^ 0.1 + x % 0.7\ny = f(2.9) + f(a)\nz = -a % 2\n", { { "a", "123.456" } } },
+	{ "f(x) = x / 0\ny = f(0)\nz = f(a)\n", { { "a", "-1" } } },
+};
+
+// Outputs are `name = value` lines. Values which are not numbers (messages of errors)
+// must be the same text.
+static bool is_same_value(const std::string& expected, const std::string& result) {
+	if (expected == result)
+		return true;
+
+	char* expected_end = nullptr;
+	char* result_end = nullptr;
+	double expected_value = std::strtod(expected.c_str(), &expected_end);
+	double result_value = std::strtod(result.c_str(), &result_end);
+	if (*expected_end != '\0' || *result_end != '\0' || expected.empty() || result.empty())
+		return false;
+
+	if (std::isnan(expected_value) || std::isnan(result_value))
+		return std::isnan(expected_value) && std::isnan(result_value);
+
+	// Six decimals are printed, so a difference of the last bit may change the last digit.
+	double tolerance = 1e-6 + 1e-14 * std::max(std::fabs(expected_value), std::fabs(result_value));
+
+	return std::fabs(expected_value - result_value) <= tolerance;
+}
+
+static bool is_same_output(const std::string& expected, const std::string& result) {
+	std::istringstream expected_lines(expected);
+	std::istringstream result_lines(result);
+	std::string expected_line;
+	std::string result_line;
+
+	while (std::getline(expected_lines, expected_line)) {
+		if (!std::getline(result_lines, result_line))
+			return false;
+
+		auto equal = expected_line.find(" = ");
+		if (equal == std::string::npos || result_line.compare(0, equal + 3, expected_line, 0, equal + 3) != 0) {
+			if (expected_line != result_line)
+				return false;
+
+			continue;
+		}
+
+		if (!is_same_value(expected_line.substr(equal + 3), result_line.substr(equal + 3)))
+			return false;
+	}
+
+	return !std::getline(result_lines, result_line);
+}
+
+// Returns the printed outputs or the message of the error.
+static std::string evaluate(const test_case& test_case, evaluation_engine engine) {
+	try {
+		parser parser(test_case.text);
+		const ast_program* program = parser.parse_program();
+
+		evaluation_options options;
+		options.engine = engine;
+
+		std::ostringstream out;
+		try {
+			evaluate(program, test_case.arguments, out, options);
+		}
+		catch (...) {
+			delete program;
+
+			throw;
+		}
+
+		delete program;
+
+		return out.str();
+	}
+	catch (std::exception* exception) {
+		std::string message = exception->what();
+		delete exception;
+
+		return "error: " + message + "\n";
+	}
+}
+
+int main() {
+	std::vector<std::pair<const char*, evaluation_engine>> engines =
+	{
+		{ "--vm", evaluation_engine::Bytecode },
+#ifdef COMCALC_LLVM
+		{ "--jit", evaluation_engine::Jit },
+#endif
+	};
+
+	int failures = 0;
+	for (const auto& test_case : test_cases) {
+		auto expected = evaluate(test_case, evaluation_engine::TreeWalk);
+
+		for (const auto& engine : engines) {
+			auto result = evaluate(test_case, engine.second);
+			if (is_same_output(expected, result))
+				continue;
+
+			std::cerr << test_case.text << "--eval:" << std::endl << expected << engine.first << ":" << std::endl << result << std::endl;
+			failures++;
+		}
+	}
+
+	if (failures != 0) {
+		std::cerr << failures << " evaluations differ from the tree-walking evaluator." << std::endl;
+
+		return 1;
+	}
+
+	std::cout << "Every engine evaluated " << std::size(test_cases) << " programs like --eval." << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,82 @@
+#include "thread_pool.h"
+
+thread_pool::thread_pool(size_t thread_count)
+	: _task(nullptr), _count(0), _next_index(0), _busy_workers(0), _generation(0), _is_stopped(false) {
+	for (size_t i = 1; i < thread_count; i++)
+		_workers.emplace_back(&thread_pool::work, this, i);
+}
+
+thread_pool::~thread_pool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_is_stopped = true;
+	}
+
+	_started.notify_all();
+
+	for (auto i = _workers.begin(); i != _workers.end(); i++)
+		i->join();
+}
+
+void thread_pool::run(size_t count, const std::function<void(size_t, size_t)>& task) {
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	_task = &task;
+	_count = count;
+	_next_index = 0;
+	_busy_workers = _workers.size();
+	_exception = nullptr;
+	_generation++;
+	_started.notify_all();
+
+	take_tasks(0, lock);
+
+	_finished.wait(lock, [this]() { return _busy_workers == 0; });
+	_task = nullptr;
+
+	if (_exception) {
+		auto exception = _exception;
+		_exception = nullptr;
+
+		std::rethrow_exception(exception);
+	}
+}
+
+void thread_pool::work(size_t thread) {
+	std::unique_lock<std::mutex> lock(_mutex);
+	size_t generation = 0;
+
+	while (true) {
+		_started.wait(lock, [this, generation]() { return _is_stopped || _generation != generation; });
+		if (_is_stopped)
+			return;
+
+		generation = _generation;
+		take_tasks(thread, lock);
+
+		if (--_busy_workers == 0)
+			_finished.notify_one();
+	}
+}
+
+void thread_pool::take_tasks(size_t thread, std::unique_lock<std::mutex>& lock) {
+	// After a failure the remaining indices are skipped.
+	while (_next_index < _count && !_exception) {
+		size_t index = _next_index++;
+
+		lock.unlock();
+
+		try {
+			(*_task)(thread, index);
+		}
+		catch (...) {
+			lock.lock();
+			if (!_exception)
+				_exception = std::current_exception();
+
+			continue;
+		}
+
+		lock.lock();
+	}
+}
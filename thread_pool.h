@@ -0,0 +1,50 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running one parallel loop at a time.
+class thread_pool
+{
+public:
+	// The calling thread takes part in every loop, so `thread_count - 1` workers are started.
+	thread_pool(size_t thread_count);
+
+	~thread_pool();
+
+	thread_pool(const thread_pool&) = delete;
+
+	thread_pool& operator=(const thread_pool&) = delete;
+
+	size_t thread_count() const { return _workers.size() + 1; }
+
+	// Calls `task(thread, index)` for every index below `count` and returns when all the
+	// calls are done. `thread` is below thread_count(), calls with the same `thread` never
+	// run at once. The first exception thrown by a call is rethrown here.
+	void run(size_t count, const std::function<void(size_t, size_t)>& task);
+
+private:
+	std::vector<std::thread> _workers;
+	std::mutex _mutex;
+	std::condition_variable _started;
+	std::condition_variable _finished;
+	const std::function<void(size_t, size_t)>* _task;
+	size_t _count;
+	size_t _next_index;
+	size_t _busy_workers;
+	size_t _generation;
+	bool _is_stopped;
+	std::exception_ptr _exception;
+
+	void work(size_t thread);
+
+	void take_tasks(size_t thread, std::unique_lock<std::mutex>& lock);
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include <cmath>
+#include <map>
+#include <stdexcept>
+
+#include "value.h"
+
+static const std::map<std::string, unary_function> unary_standard_functions =
+{
+	{ "acos", [](double x) { return std::acos(x); } },
+	{ "asin", [](double x) { return std::asin(x); } },
+	{ "atan", [](double x) { return std::atan(x); } },
+	{ "cos", [](double x) { return std::cos(x); } },
+	{ "exp", [](double x) { return std::exp(x); } },
+	{ "fabs", [](double x) { return std::fabs(x); } },
+	{ "log", [](double x) { return std::log(x); } },
+	{ "log10", [](double x) { return std::log10(x); } },
+	{ "sin", [](double x) { return std::sin(x); } },
+	{ "sqrt", [](double x) { return std::sqrt(x); } },
+	{ "tan", [](double x) { return std::tan(x); } },
+};
+
+static const std::map<std::string, binary_function> binary_standard_functions =
+{
+	{ "atan2", [](double y, double x) { return std::atan2(y, x); } },
+};
+
+value calculate(binary_operation operation, value left, value right) {
+	if (operation == binary_operation::Pow)
+		return value(std::pow(left.as_double(), right.as_double()));
+
+	if (left.type() == expression_type::Double || right.type() == expression_type::Double) {
+		double l = left.as_double();
+		double r = right.as_double();
+
+		if (operation == binary_operation::Add)
+			return value(l + r);
+
+		if (operation == binary_operation::Subtract)
+			return value(l - r);
+
+		if (operation == binary_operation::Multiply)
+			return value(l * r);
+
+		if (operation == binary_operation::Divide)
+			return value(l / r);
+
+		if (operation == binary_operation::Reminder)
+			return value(std::fmod(l, r));
+	}
+	else {
+		long l = left.as_long();
+		long r = right.as_long();
+
+		if (operation == binary_operation::Add)
+			return value(l + r);
+
+		if (operation == binary_operation::Subtract)
+			return value(l - r);
+
+		if (operation == binary_operation::Multiply)
+			return value(l * r);
+
+		if ((operation == binary_operation::Divide || operation == binary_operation::Reminder) && r == 0)
+			throw new std::runtime_error("Division by zero.");
+
+		if (operation == binary_operation::Divide)
+			return value(l / r);
+
+		if (operation == binary_operation::Reminder)
+			return value(l % r);
+	}
+
+	throw new std::runtime_error("Invalid binary operation.");
+}
+
+value calculate(unary_operation operation, value operand) {
+	if (operation == unary_operation::Positive)
+		return operand;
+
+	if (operand.type() == expression_type::Double)
+		return value(-operand.as_double());
+
+	return value(-operand.as_long());
+}
+
+bool compare(const std::string& operation, value left, value right) {
+	if (left.type() == expression_type::Double || right.type() == expression_type::Double) {
+		double l = left.as_double();
+		double r = right.as_double();
+
+		if (operation == ">")
+			return l > r;
+
+		if (operation == ">=")
+			return l >= r;
+
+		if (operation == "<")
+			return l < r;
+
+		if (operation == "<=")
+			return l <= r;
+
+		if (operation == "<>")
+			return l != r;
+
+		if (operation == "=")
+			return l == r;
+	}
+	else {
+		long l = left.as_long();
+		long r = right.as_long();
+
+		if (operation == ">")
+			return l > r;
+
+		if (operation == ">=")
+			return l >= r;
+
+		if (operation == "<")
+			return l < r;
+
+		if (operation == "<=")
+			return l <= r;
+
+		if (operation == "<>")
+			return l != r;
+
+		if (operation == "=")
+			return l == r;
+	}
+
+	throw new std::runtime_error("Invalid comparison operation `" + operation + "`.");
+}
+
+value parse_value(const std::string& text, expression_type type) {
+	size_t length = 0;
+
+	try {
+		if (type == expression_type::Double) {
+			double result = std::stod(text, &length);
+
+			if (length == text.length())
+				return value(result);
+		}
+		else {
+			long result = std::stol(text, &length);
+
+			if (length == text.length())
+				return value(result);
+		}
+	}
+	catch (std::exception&) {
+	}
+
+	throw new std::runtime_error("Invalid " + to_string(type) + " value `" + text + "`.");
+}
+
+unary_function find_unary_standard_function(const std::string& name) {
+	auto function = unary_standard_functions.find(name);
+
+	return function != unary_standard_functions.end() ? function->second : nullptr;
+}
+
+binary_function find_binary_standard_function(const std::string& name) {
+	auto function = binary_standard_functions.find(name);
+
+	return function != binary_standard_functions.end() ? function->second : nullptr;
+}
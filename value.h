@@ -0,0 +1,77 @@
+#ifndef __VALUE_H__
+#define __VALUE_H__
+
+#include <cstring>
+#include <string>
+
+#include "ast.h"
+#include "expression.h"
+
+class value
+{
+private:
+	expression_type _type;
+	long _long;
+	double _double;
+
+public:
+	value() : _type(expression_type::Long), _long(0), _double(0.0) { }
+
+	value(long long_value) : _type(expression_type::Long), _long(long_value), _double(0.0) { }
+
+	value(double double_value) : _type(expression_type::Double), _long(0), _double(double_value) { }
+
+	expression_type type() const { return _type; }
+
+	long as_long() const { return _type == expression_type::Long ? _long : (long)_double; }
+
+	double as_double() const { return _type == expression_type::Long ? (double)_long : _double; }
+
+	value cast_to(expression_type type) const {
+		if (type == expression_type::Double)
+			return value(as_double());
+
+		return value(as_long());
+	}
+
+	// Values are identical when they have the same type and the same bits, so `-0.0`
+	// differs from `0.0` and NaN is identical to itself.
+	bool is_identical(value other) const {
+		if (_type != other._type)
+			return false;
+
+		if (_type == expression_type::Double)
+			return std::memcmp(&_double, &other._double, sizeof(double)) == 0;
+
+		return _long == other._long;
+	}
+
+	// Formats the value the same way the generated code prints it (`%ld` or `%lf`).
+	std::string to_string() const {
+		if (_type == expression_type::Double)
+			return std::to_string(_double);
+
+		return std::to_string(_long);
+	}
+};
+
+// Arithmetic follows the generated code: `long` operands are converted to `double`
+// when the other operand is `double`, and `^` is always computed as `double`.
+value calculate(binary_operation operation, value left, value right);
+
+value calculate(unary_operation operation, value operand);
+
+bool compare(const std::string& operation, value left, value right);
+
+value parse_value(const std::string& text, expression_type type);
+
+typedef double (*unary_function)(double);
+
+typedef double (*binary_function)(double, double);
+
+// Returns nullptr if there is no standard function with such name and number of parameters.
+unary_function find_unary_standard_function(const std::string& name);
+
+binary_function find_binary_standard_function(const std::string& name);
+
+#endif